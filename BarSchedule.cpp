@@ -0,0 +1,232 @@
+#include "BarSchedule.h"
+
+#include <cmath>
+#include <cstdio>
+
+// ---------------------------------------------------------------------------
+// Barten contrast sensitivity
+// ---------------------------------------------------------------------------
+
+namespace
+{
+
+const double PI = 3.14159265358979323846;
+
+// ITU-R BT.2246 / SMPTE ST 2084 derivation parameters
+const double BARTEN_K     = 3.0;        // signal-to-noise ratio
+const double BARTEN_T     = 0.1;        // integration time, s
+const double BARTEN_ETA   = 0.03;       // quantum efficiency
+const double BARTEN_SIGMA = 0.5;        // optical spread, arcmin
+const double BARTEN_CAB   = 0.08;       // spread per mm of pupil, arcmin/mm
+const double BARTEN_XMAX  = 12.0;       // integration area, deg
+const double BARTEN_NMAX  = 15.0;       // integration cycles
+const double BARTEN_PHI0  = 3e-8;       // neural noise, s deg^2
+const double BARTEN_U0    = 7.0;        // lateral inhibition cut-off, cycles/deg
+const double BARTEN_P     = 1.2274e6;   // photon conversion, photons / (s deg^2 Td)
+const double BARTEN_X0    = 40.0;       // field size, deg
+
+// Frequency search range (cycles/deg) for the peak sensitivity
+const double FREQ_MIN   = 0.05;
+const double FREQ_MAX   = 60.0;
+const int    FREQ_STEPS = 48;
+
+// JND integration: log-luminance nodes across the whole range. The threshold
+// changes slowly in log luminance, so a few hundred nodes are far finer than
+// any schedule needs.
+const int    JND_NODES  = 512;
+
+double BartenSensitivity(double nits, double u)
+{
+    // Pupil diameter (mm) and retinal illuminance (Td) for a 40 degree field
+    double d = 5.0 - 3.0 * tanh(0.4 * log10(nits * BARTEN_X0 * BARTEN_X0 / (40.0 * 40.0)));
+    double e = PI * d * d / 4.0 * nits * (1.0 - pow(d / 9.7, 2.0) + pow(d / 12.4, 4.0));
+
+    double sigma = sqrt(BARTEN_SIGMA * BARTEN_SIGMA + BARTEN_CAB * d * BARTEN_CAB * d) / 60.0;
+    double mopt  = exp(-2.0 * PI * PI * sigma * sigma * u * u);
+
+    double area  = 1.0 / (BARTEN_X0 * BARTEN_X0) + 1.0 / (BARTEN_XMAX * BARTEN_XMAX) + u * u / (BARTEN_NMAX * BARTEN_NMAX);
+    double noise = 1.0 / (BARTEN_ETA * BARTEN_P * e) + BARTEN_PHI0 / (1.0 - exp(-(u / BARTEN_U0) * (u / BARTEN_U0)));
+    return mopt / BARTEN_K / sqrt(2.0 / BARTEN_T * area * noise);
+}
+
+// JNDs per unit of ln(nits): one JND spans the modulation threshold m,
+// i.e. ln((1 + m) / (1 - m)) in log luminance
+double JndDensity(double logNits)
+{
+    double m = BartenThreshold(exp(logNits));
+    if (m > 0.99) m = 0.99;
+    return 1.0 / log((1.0 + m) / (1.0 - m));
+}
+
+// Bars evenly spaced in Barten JND index between p.startNits and p.endNits
+void BuildJndSchedule(const PatternParams& p, std::vector<float>& out)
+{
+    const double l0 = log((double)p.startNits);
+    const double l1 = log((double)p.endNits);
+
+    // Cumulative JND index at each node (trapezoid rule)
+    std::vector<double> index(JND_NODES + 1);
+    const double step = (l1 - l0) / JND_NODES;
+    double prev = JndDensity(l0);
+    index[0] = 0.0;
+    for (int i = 1; i <= JND_NODES; i++)
+    {
+        double cur = JndDensity(l0 + step * i);
+        index[i] = index[i - 1] + 0.5 * (prev + cur) * fabs(step);
+        prev = cur;
+    }
+
+    // Invert: walk the nodes once, interpolating ln(nits) inside each
+    const double total = index[JND_NODES];
+    int node = 0;
+    for (int b = 1; b + 1 < p.numBars; b++)
+    {
+        double target = total * (double)b / (double)(p.numBars - 1);
+        while (node + 1 < JND_NODES && index[node + 1] < target) node++;
+        double span = index[node + 1] - index[node];
+        double f    = (span > 0.0) ? (target - index[node]) / span : 0.0;
+        out[b] = (float)exp(l0 + step * (node + f));
+    }
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+const char* BarSpacingName(BarSpacing spacing)
+{
+    switch (spacing)
+    {
+    case BAR_SPACING_LINEAR: return "linear";
+    case BAR_SPACING_PQ:     return "pq";
+    case BAR_SPACING_LOG:    return "log";
+    case BAR_SPACING_JND:    return "jnd";
+    case BAR_SPACING_LIST:   return "list";
+    }
+    return "?";
+}
+
+double BartenThreshold(double nits)
+{
+    if (!(nits > 0.0)) return 1.0;
+
+    // Coarse log-spaced search for the peak, then golden-section refinement
+    const double lo = log(FREQ_MIN), hi = log(FREQ_MAX);
+    int    best  = 0;
+    double bestS = 0.0;
+    for (int i = 0; i <= FREQ_STEPS; i++)
+    {
+        double s = BartenSensitivity(nits, exp(lo + (hi - lo) * i / FREQ_STEPS));
+        if (s > bestS) { bestS = s; best = i; }
+    }
+
+    const double g = 0.61803398874989484820;
+    double a = lo + (hi - lo) * (best > 0 ? best - 1 : 0) / FREQ_STEPS;
+    double b = lo + (hi - lo) * (best < FREQ_STEPS ? best + 1 : FREQ_STEPS) / FREQ_STEPS;
+    for (int i = 0; i < 40; i++)
+    {
+        double c  = b - g * (b - a);
+        double d  = a + g * (b - a);
+        if (BartenSensitivity(nits, exp(c)) > BartenSensitivity(nits, exp(d))) b = d;
+        else                                                                  a = c;
+    }
+    double s = BartenSensitivity(nits, exp(0.5 * (a + b)));
+    if (s < bestS) s = bestS;
+    return 1.0 / s;
+}
+
+bool BuildBarSchedule(BarSpacing spacing, const PatternParams& p, const std::vector<float>& levels,
+    std::vector<float>& out, std::string* error)
+{
+    out.clear();
+    if (p.numBars < 1)
+    {
+        if (error) *error = "no bars";
+        return false;
+    }
+
+    if (spacing == BAR_SPACING_LIST)
+    {
+        if ((int)levels.size() != p.numBars)
+        {
+            if (error) *error = "level count does not match the bar count";
+            return false;
+        }
+        out = levels;
+        return true;
+    }
+
+    if ((spacing == BAR_SPACING_LOG || spacing == BAR_SPACING_JND) && !(p.startNits > 0.0f && p.endNits > 0.0f))
+    {
+        if (error) *error = std::string(BarSpacingName(spacing)) + " spacing needs a range above 0 nits";
+        return false;
+    }
+
+    out.resize((size_t)p.numBars);
+    const int last = p.numBars - 1;
+
+    switch (spacing)
+    {
+    case BAR_SPACING_PQ:
+    {
+        double from = PatternPQEncode(p.startNits), to = PatternPQEncode(p.endNits);
+        for (int b = 1; b < last; b++)
+            out[b] = (float)PatternPQDecode(from + (to - from) * (double)b / (double)last);
+        break;
+    }
+    case BAR_SPACING_LOG:
+    {
+        double ratio = (double)p.endNits / (double)p.startNits;
+        for (int b = 1; b < last; b++)
+            out[b] = (float)((double)p.startNits * pow(ratio, (double)b / (double)last));
+        break;
+    }
+    case BAR_SPACING_JND:
+        BuildJndSchedule(p, out);
+        break;
+    default:
+    {
+        // Same float lerp as the shader
+        PatternParams linear = p;
+        linear.barNits = nullptr;
+        for (int b = 1; b < last; b++)
+            out[b] = PatternBarNits(linear, b);
+        break;
+    }
+    }
+
+    // Both ends exactly as entered
+    out[0] = p.startNits;
+    if (last > 0) out[last] = p.endNits;
+    return true;
+}
+
+bool LoadBarLevels(const char* path, std::vector<float>& levels, std::string* error)
+{
+    levels.clear();
+    FILE* f = fopen(path, "r");
+    if (!f)
+    {
+        if (error) *error = std::string("cannot open ") + path;
+        return false;
+    }
+
+    float v;
+    int   n;
+    while ((n = fscanf(f, "%f", &v)) == 1)
+    {
+        if (!(v >= 0.0f && v <= 10000.0f)) { n = 0; break; }
+        levels.push_back(v);
+    }
+    fclose(f);
+
+    if (n != EOF || levels.empty())
+    {
+        if (error) *error = std::string(path) + ": expected luminances in 0-10000 nits";
+        levels.clear();
+        return false;
+    }
+    return true;
+}
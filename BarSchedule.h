@@ -0,0 +1,45 @@
+#pragma once
+
+// ---------------------------------------------------------------------------
+// BarSchedule
+//
+// Per-bar luminance schedules. The shader's own spacing is linear in nits,
+// which near black puts most bars less than one PQ code apart; the other
+// schedules spread the bars evenly in PQ signal, in log luminance, in Barten
+// just-noticeable differences, or take an explicit list.
+//
+// A schedule is built once per parameter change into an array of bar
+// luminances. PatternParams::barNits points the CPU renderers at it and
+// Main.cpp uploads the same floats to the shader, so a frame costs nothing
+// extra per pixel whichever schedule is used.
+// ---------------------------------------------------------------------------
+
+#include "PatternCore.h"
+
+#include <string>
+#include <vector>
+
+enum BarSpacing
+{
+    BAR_SPACING_LINEAR = 0,     // lerp in nits, as the shader computes it
+    BAR_SPACING_PQ     = 1,     // equal steps of PQ signal (code)
+    BAR_SPACING_LOG    = 2,     // equal luminance ratios
+    BAR_SPACING_JND    = 3,     // equal numbers of Barten JNDs
+    BAR_SPACING_LIST   = 4      // explicit levels, one per bar
+};
+
+const char* BarSpacingName(BarSpacing spacing);
+
+// Fills `out` with p.numBars luminances from p.startNits to p.endNits (both
+// exact). LIST copies `levels`, which must hold p.numBars values. Fails if
+// LOG / JND get a luminance of 0.
+bool BuildBarSchedule(BarSpacing spacing, const PatternParams& p, const std::vector<float>& levels,
+    std::vector<float>& out, std::string* error);
+
+// Barten contrast sensitivity model (ITU-R BT.2246 parameters, 40 degree
+// field): the smallest detectable modulation at `nits`, maximised over
+// spatial frequency.
+double BartenThreshold(double nits);
+
+// Reads whitespace separated luminances (nits), e.g. for LIST spacing
+bool LoadBarLevels(const char* path, std::vector<float>& levels, std::string* error);
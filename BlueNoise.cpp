@@ -0,0 +1,150 @@
+#include "BlueNoise.h"
+
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// Void-and-cluster (Ulichney 1993)
+// ---------------------------------------------------------------------------
+
+namespace
+{
+
+const int   N         = BLUE_NOISE_SIZE * BLUE_NOISE_SIZE;
+const float SIGMA     = 1.5f;
+const int   SEED_FILL = N / 10;         // initial random points
+const uint32_t SEED   = 0x5EEDB10Eu;
+
+// Toroidal Gaussian energy field over a binary pattern. Adding or removing a
+// point updates every cell, so each step is O(N).
+class EnergyField
+{
+public:
+    EnergyField() : m_kernel(N), m_energy(N, 0.0f), m_bits(N, 0)
+    {
+        for (int dy = 0; dy < BLUE_NOISE_SIZE; dy++)
+        for (int dx = 0; dx < BLUE_NOISE_SIZE; dx++)
+        {
+            // Shortest wrapped distance
+            int wx = (dx <= BLUE_NOISE_SIZE / 2) ? dx : BLUE_NOISE_SIZE - dx;
+            int wy = (dy <= BLUE_NOISE_SIZE / 2) ? dy : BLUE_NOISE_SIZE - dy;
+            m_kernel[dy * BLUE_NOISE_SIZE + dx] = expf(-(float)(wx * wx + wy * wy) / (2.0f * SIGMA * SIGMA));
+        }
+    }
+
+    bool Bit(int i) const { return m_bits[i] != 0; }
+
+    void Set(int i, bool on)
+    {
+        if (Bit(i) == on) return;
+        m_bits[i] = on ? 1 : 0;
+
+        const float sign = on ? 1.0f : -1.0f;
+        const int   px = i & BLUE_NOISE_MASK;
+        const int   py = i / BLUE_NOISE_SIZE;
+        for (int y = 0; y < BLUE_NOISE_SIZE; y++)
+        {
+            const float* k = &m_kernel[((y - py) & BLUE_NOISE_MASK) * BLUE_NOISE_SIZE];
+            float*       e = &m_energy[y * BLUE_NOISE_SIZE];
+            for (int x = 0; x < BLUE_NOISE_SIZE; x++)
+                e[x] += sign * k[(x - px) & BLUE_NOISE_MASK];
+        }
+    }
+
+    // Densest set point; ties resolve to the lowest index
+    int TightestCluster() const
+    {
+        int best = -1;
+        for (int i = 0; i < N; i++)
+            if (m_bits[i] && (best < 0 || m_energy[i] > m_energy[best])) best = i;
+        return best;
+    }
+
+    // Emptiest clear point
+    int LargestVoid() const
+    {
+        int best = -1;
+        for (int i = 0; i < N; i++)
+            if (!m_bits[i] && (best < 0 || m_energy[i] < m_energy[best])) best = i;
+        return best;
+    }
+
+private:
+    std::vector<float>   m_kernel;
+    std::vector<float>   m_energy;
+    std::vector<uint8_t> m_bits;
+};
+
+void BuildRanks(std::vector<int>& rank)
+{
+    rank.assign(N, 0);
+
+    // Seeded random initial pattern
+    EnergyField initial;
+    uint32_t state = SEED;
+    for (int placed = 0; placed < SEED_FILL; )
+    {
+        state = state * 1664525u + 1013904223u;
+        int i = (int)(state >> 20) & (N - 1);
+        if (initial.Bit(i)) continue;
+        initial.Set(i, true);
+        placed++;
+    }
+
+    // Relax it: move the tightest cluster into the largest void until stable
+    for (;;)
+    {
+        int cluster = initial.TightestCluster();
+        initial.Set(cluster, false);
+        int hole = initial.LargestVoid();
+        initial.Set(hole, true);
+        if (hole == cluster) break;
+    }
+
+    // Ranks below the seed count: remove clusters from a copy
+    EnergyField field = initial;
+    for (int r = SEED_FILL - 1; r >= 0; r--)
+    {
+        int cluster = field.TightestCluster();
+        field.Set(cluster, false);
+        rank[cluster] = r;
+    }
+
+    // Remaining ranks: fill voids from the seed pattern up
+    for (int r = SEED_FILL; r < N; r++)
+    {
+        int hole = initial.LargestVoid();
+        initial.Set(hole, true);
+        rank[hole] = r;
+    }
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+const float* BlueNoiseMask()
+{
+    struct Table
+    {
+        float mask[N];
+        Table()
+        {
+            std::vector<int> rank;
+            BuildRanks(rank);
+            for (int i = 0; i < N; i++)
+                mask[i] = ((float)rank[i] + 0.5f) / (float)N;
+        }
+    };
+    static const Table s_table;
+    return s_table.mask;
+}
+
+float BlueNoisePhase(uint64_t frame)
+{
+    // Golden-ratio additive recurrence, reduced in double precision
+    const double golden = 0.61803398874989484820;
+    float phase = (float)fmod((double)frame * golden, 1.0);
+    return (phase < 1.0f) ? phase : 0.0f;
+}
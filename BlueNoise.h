@@ -0,0 +1,38 @@
+#pragma once
+
+// ---------------------------------------------------------------------------
+// BlueNoise
+//
+// Tileable blue-noise threshold mask for dithering bars between two adjacent
+// PQ codes. The mask is a 64x64 void-and-cluster rank map, generated once on
+// first use from a fixed seed (so every run and every tool sees the same
+// mask) and uploaded to the GPU once at start-up; at frame time both the
+// shader and the CPU renderer only do a table lookup per pixel.
+//
+// Temporal dithering shifts every threshold by a per-frame phase stepping
+// through the golden-ratio sequence, which keeps each frame blue in space
+// while every pixel cycles evenly through the threshold range over time.
+//
+// This header is pulled into Main.cpp after <windows.h>, so it avoids
+// std::min/std::max in inline code.
+// ---------------------------------------------------------------------------
+
+#include <cstdint>
+#include <cmath>
+
+static const int BLUE_NOISE_SIZE = 64;     // tile edge; power of two (must match the shader)
+static const int BLUE_NOISE_MASK = BLUE_NOISE_SIZE - 1;
+
+// BLUE_NOISE_SIZE^2 thresholds in (0, 1), row-major: (rank + 0.5) / 4096
+const float* BlueNoiseMask();
+
+// Threshold for one mask entry at `phase`; frac(mask + phase), as the
+// shader computes it
+inline float BlueNoiseThreshold(float mask, float phase)
+{
+    float t = mask + phase;
+    return t - floorf(t);
+}
+
+// Phase for frame `frame` of a temporally dithered sequence, in [0, 1)
+float BlueNoisePhase(uint64_t frame);
@@ -0,0 +1,153 @@
+#pragma once
+
+// ---------------------------------------------------------------------------
+// BoundedQueue
+//
+// Fixed-capacity lock-free multi-producer / multi-consumer queue (Vyukov's
+// sequence-numbered ring). Push/Pop back off when the ring is full or empty;
+// Close() lets consumers drain and stop.
+// ---------------------------------------------------------------------------
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <utility>
+#include <vector>
+
+template<typename T>
+class BoundedQueue
+{
+public:
+    // Capacity is rounded up to a power of two
+    explicit BoundedQueue(size_t capacity)
+    {
+        size_t cap = 2;
+        while (cap < capacity) cap <<= 1;
+        m_mask  = cap - 1;
+        m_cells = std::vector<Cell>(cap);
+        for (size_t i = 0; i < cap; i++)
+            m_cells[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    bool TryPush(T& value)
+    {
+        size_t pos = m_tail.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Cell& cell = m_cells[pos & m_mask];
+            size_t seq = cell.seq.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0)
+            {
+                if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    cell.value = std::move(value);
+                    cell.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;   // full
+            }
+            else
+            {
+                pos = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool TryPop(T& value)
+    {
+        size_t pos = m_head.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Cell& cell = m_cells[pos & m_mask];
+            size_t seq = cell.seq.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+            if (diff == 0)
+            {
+                if (m_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    value = std::move(cell.value);
+                    cell.seq.store(pos + m_mask + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;   // empty
+            }
+            else
+            {
+                pos = m_head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Blocks until there is room. Returns the number of times it had to wait.
+    size_t Push(T& value)
+    {
+        size_t stalls = 0;
+        while (!TryPush(value)) Backoff(stalls++);
+        return stalls;
+    }
+
+    // Blocks until an item arrives; returns false once the queue is closed
+    // and drained.
+    bool Pop(T& value, size_t* stalls = nullptr)
+    {
+        size_t n = 0;
+        for (;;)
+        {
+            if (TryPop(value)) break;
+            if (m_closed.load(std::memory_order_acquire))
+            {
+                // Re-check: a producer may have pushed just before closing
+                if (TryPop(value)) break;
+                if (stalls) *stalls += n;
+                return false;
+            }
+            Backoff(n++);
+        }
+        if (stalls) *stalls += n;
+        return true;
+    }
+
+    void Close() { m_closed.store(true, std::memory_order_release); }
+
+private:
+    struct Cell
+    {
+        std::atomic<size_t> seq;
+        T                   value;
+
+        Cell() : seq(0), value() {}
+        Cell(Cell&& other) noexcept : seq(other.seq.load()), value(std::move(other.value)) {}
+        Cell& operator=(Cell&& other) noexcept
+        {
+            seq.store(other.seq.load());
+            value = std::move(other.value);
+            return *this;
+        }
+    };
+
+    // Spin, then yield, then sleep so a stalled stage does not burn a core
+    static void Backoff(size_t attempt)
+    {
+        if (attempt < 16) return;
+        if (attempt < 256) { std::this_thread::yield(); return; }
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+
+    alignas(64) std::atomic<size_t> m_head{ 0 };
+    alignas(64) std::atomic<size_t> m_tail{ 0 };
+    alignas(64) std::atomic<bool>   m_closed{ false };
+    size_t            m_mask = 0;
+    std::vector<Cell> m_cells;
+};
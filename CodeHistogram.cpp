@@ -0,0 +1,496 @@
+#include "CodeHistogram.h"
+#include "Parallel.h"
+
+#include <cstdio>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define CODEHIST_SSE2 1
+#endif
+
+// ---------------------------------------------------------------------------
+// Per-worker state
+// ---------------------------------------------------------------------------
+
+namespace
+{
+
+struct RunStats
+{
+    uint64_t pixels;
+    uint64_t ditherPixels;  // pixels on the alternate (upper dither) texel
+    uint64_t unexpected;
+    uint64_t codeSum;
+    uint32_t minCode;
+    uint32_t maxCode;
+    int      maxDeviation;
+};
+
+struct WorkerState
+{
+    uint32_t              hist[3][PQ_CODE_BINS];
+    std::vector<RunStats> bars;
+    RunStats              sep;
+};
+
+void ResetStats(RunStats& s)
+{
+    s.pixels       = 0;
+    s.ditherPixels = 0;
+    s.unexpected   = 0;
+    s.codeSum      = 0;
+    s.minCode      = PQ_CODE_MAX;
+    s.maxCode      = 0;
+    s.maxDeviation = 0;
+}
+
+void MergeStats(RunStats& dst, const RunStats& src)
+{
+    dst.pixels       += src.pixels;
+    dst.ditherPixels += src.ditherPixels;
+    dst.unexpected   += src.unexpected;
+    dst.codeSum    += src.codeSum;
+    if (src.pixels == 0) return;
+    if (src.minCode < dst.minCode) dst.minCode = src.minCode;
+    if (src.maxCode > dst.maxCode) dst.maxCode = src.maxCode;
+    if (src.maxDeviation > dst.maxDeviation) dst.maxDeviation = src.maxDeviation;
+}
+
+// Records one off-expectation pixel. `stats` is null for the label column,
+// where text pixels legitimately differ from the black background.
+inline void RecordMismatch(uint32_t (*hist)[PQ_CODE_BINS], const uint32_t code[3],
+    uint32_t expectedCode, RunStats* stats)
+{
+    hist[0][code[0]]++;
+    hist[1][code[1]]++;
+    hist[2][code[2]]++;
+
+    if (!stats) return;
+    stats->unexpected++;
+    for (int c = 0; c < 3; c++)
+    {
+        int dev = (int)code[c] - (int)expectedCode;
+        if (dev < 0) dev = -dev;
+        if (dev > stats->maxDeviation) stats->maxDeviation = dev;
+        if (code[c] < stats->minCode) stats->minCode = code[c];
+        if (code[c] > stats->maxCode) stats->maxCode = code[c];
+        stats->codeSum += code[c];
+    }
+}
+
+inline void RecordMatches(uint32_t (*hist)[PQ_CODE_BINS], uint64_t matched,
+    uint32_t expectedCode, RunStats* stats)
+{
+    hist[0][expectedCode] += (uint32_t)matched;
+    hist[1][expectedCode] += (uint32_t)matched;
+    hist[2][expectedCode] += (uint32_t)matched;
+
+    if (!stats || matched == 0) return;
+    if (expectedCode < stats->minCode) stats->minCode = expectedCode;
+    if (expectedCode > stats->maxCode) stats->maxCode = expectedCode;
+    stats->codeSum += matched * 3 * expectedCode;
+}
+
+// ---------------------------------------------------------------------------
+// R10G10B10A2 scan
+// ---------------------------------------------------------------------------
+
+inline uint32_t BitCount16(uint32_t m)
+{
+    m = m - ((m >> 1) & 0x5555u);
+    m = (m & 0x3333u) + ((m >> 2) & 0x3333u);
+    m = (m + (m >> 4)) & 0x0F0Fu;
+    return (m + (m >> 8)) & 0x1Fu;
+}
+
+#ifdef CODEHIST_SSE2
+// One bit per 32-bit lane of a compare result
+inline uint32_t LaneMask32(__m128i m) { return (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(m)); }
+
+// One bit per 64-bit lane of a compare result
+inline uint32_t LaneMask64(__m128i m) { return (uint32_t)_mm_movemask_pd(_mm_castsi128_pd(m)); }
+
+// 64-bit lane equality from two 32-bit compares (SSE2 has no _mm_cmpeq_epi64)
+inline __m128i CmpEq64(__m128i a, __m128i b)
+{
+    __m128i e = _mm_cmpeq_epi32(a, b);
+    return _mm_and_si128(e, _mm_shuffle_epi32(e, _MM_SHUFFLE(2, 3, 0, 1)));
+}
+#endif
+
+inline void Mismatch10(uint32_t (*hist)[PQ_CODE_BINS], uint32_t px,
+    uint32_t expectedCode, RunStats* stats)
+{
+    uint32_t code[3] = { px & 0x3FFu, (px >> 10) & 0x3FFu, (px >> 20) & 0x3FFu };
+    RecordMismatch(hist, code, expectedCode, stats);
+}
+
+// `expected` and `alt` are packed texels with alpha masked off; `alt` is the
+// upper dither code of a dithered bar and equals `expected` otherwise.
+void ScanRun10(const uint32_t* px, int n, uint32_t expected, uint32_t expectedCode,
+    uint32_t alt, uint32_t altCode, uint32_t (*hist)[PQ_CODE_BINS], RunStats* stats)
+{
+    const uint32_t rgbMask = 0x3FFFFFFFu;
+    uint64_t matched = 0;
+    uint64_t altMatched = 0;
+    int i = 0;
+
+#ifdef CODEHIST_SSE2
+    const __m128i vMask = _mm_set1_epi32((int)rgbMask);
+    const __m128i vExp  = _mm_set1_epi32((int)expected);
+    const __m128i vAlt  = _mm_set1_epi32((int)alt);
+
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i a = _mm_and_si128(_mm_loadu_si128((const __m128i*)(px + i)),      vMask);
+        __m128i b = _mm_and_si128(_mm_loadu_si128((const __m128i*)(px + i + 4)),  vMask);
+        __m128i c = _mm_and_si128(_mm_loadu_si128((const __m128i*)(px + i + 8)),  vMask);
+        __m128i d = _mm_and_si128(_mm_loadu_si128((const __m128i*)(px + i + 12)), vMask);
+        __m128i ea = _mm_cmpeq_epi32(a, vExp), fa = _mm_cmpeq_epi32(a, vAlt);
+        __m128i eb = _mm_cmpeq_epi32(b, vExp), fb = _mm_cmpeq_epi32(b, vAlt);
+        __m128i ec = _mm_cmpeq_epi32(c, vExp), fc = _mm_cmpeq_epi32(c, vAlt);
+        __m128i ed = _mm_cmpeq_epi32(d, vExp), fd = _mm_cmpeq_epi32(d, vAlt);
+        __m128i all = _mm_and_si128(_mm_and_si128(_mm_or_si128(ea, fa), _mm_or_si128(eb, fb)),
+                                    _mm_and_si128(_mm_or_si128(ec, fc), _mm_or_si128(ed, fd)));
+
+        if (_mm_movemask_epi8(all) == 0xFFFF)
+        {
+            // Every lane is on one of the two codes; lanes on `alt` only
+            // (none when alt == expected) are the dither pixels
+            uint32_t altLanes = LaneMask32(_mm_andnot_si128(ea, fa))
+                              | LaneMask32(_mm_andnot_si128(eb, fb)) << 4
+                              | LaneMask32(_mm_andnot_si128(ec, fc)) << 8
+                              | LaneMask32(_mm_andnot_si128(ed, fd)) << 12;
+            uint32_t nAlt = BitCount16(altLanes);
+            altMatched += nAlt;
+            matched    += 16 - nAlt;
+            continue;
+        }
+
+        // Rare path: at least one lane is off-code
+        for (int k = 0; k < 16; k++)
+        {
+            uint32_t p = px[i + k];
+            if      ((p & rgbMask) == expected) matched++;
+            else if ((p & rgbMask) == alt)      altMatched++;
+            else Mismatch10(hist, p, expectedCode, stats);
+        }
+    }
+#endif
+
+    for (; i < n; i++)
+    {
+        uint32_t p = px[i];
+        if      ((p & rgbMask) == expected) matched++;
+        else if ((p & rgbMask) == alt)      altMatched++;
+        else Mismatch10(hist, p, expectedCode, stats);
+    }
+
+    if (stats) stats->pixels += (uint64_t)n;
+    if (stats) stats->ditherPixels += altMatched;
+    RecordMatches(hist, matched, expectedCode, stats);
+    RecordMatches(hist, altMatched, altCode, stats);
+}
+
+// ---------------------------------------------------------------------------
+// RGBA16F scan
+// ---------------------------------------------------------------------------
+
+inline void Mismatch16(uint32_t (*hist)[PQ_CODE_BINS], uint64_t px, const uint16_t* lut,
+    uint32_t expectedCode, RunStats* stats)
+{
+    uint32_t code[3] = {
+        lut[(uint16_t)px],
+        lut[(uint16_t)(px >> 16)],
+        lut[(uint16_t)(px >> 32)]
+    };
+    RecordMismatch(hist, code, expectedCode, stats);
+}
+
+// As ScanRun10; scRGB bars are never dithered, so `alt` equals `expected`
+// and the alternate lanes stay at zero.
+void ScanRun16(const uint64_t* px, int n, uint64_t expected, uint32_t expectedCode,
+    uint64_t alt, uint32_t altCode, const uint16_t* lut, uint32_t (*hist)[PQ_CODE_BINS], RunStats* stats)
+{
+    const uint64_t rgbMask = 0x0000FFFFFFFFFFFFull;
+    uint64_t matched = 0;
+    uint64_t altMatched = 0;
+    int i = 0;
+
+#ifdef CODEHIST_SSE2
+    const __m128i vMask = _mm_set_epi32(0x0000FFFF, -1, 0x0000FFFF, -1);
+    const __m128i vExp  = _mm_set_epi32((int)(expected >> 32), (int)expected,
+                                        (int)(expected >> 32), (int)expected);
+    const __m128i vAlt  = _mm_set_epi32((int)(alt >> 32), (int)alt,
+                                        (int)(alt >> 32), (int)alt);
+
+    for (; i + 8 <= n; i += 8)
+    {
+        __m128i a = _mm_and_si128(_mm_loadu_si128((const __m128i*)(px + i)),     vMask);
+        __m128i b = _mm_and_si128(_mm_loadu_si128((const __m128i*)(px + i + 2)), vMask);
+        __m128i c = _mm_and_si128(_mm_loadu_si128((const __m128i*)(px + i + 4)), vMask);
+        __m128i d = _mm_and_si128(_mm_loadu_si128((const __m128i*)(px + i + 6)), vMask);
+        __m128i ea = CmpEq64(a, vExp), fa = CmpEq64(a, vAlt);
+        __m128i eb = CmpEq64(b, vExp), fb = CmpEq64(b, vAlt);
+        __m128i ec = CmpEq64(c, vExp), fc = CmpEq64(c, vAlt);
+        __m128i ed = CmpEq64(d, vExp), fd = CmpEq64(d, vAlt);
+        __m128i all = _mm_and_si128(_mm_and_si128(_mm_or_si128(ea, fa), _mm_or_si128(eb, fb)),
+                                    _mm_and_si128(_mm_or_si128(ec, fc), _mm_or_si128(ed, fd)));
+
+        if (_mm_movemask_epi8(all) == 0xFFFF)
+        {
+            uint32_t altLanes = LaneMask64(_mm_andnot_si128(ea, fa))
+                              | LaneMask64(_mm_andnot_si128(eb, fb)) << 2
+                              | LaneMask64(_mm_andnot_si128(ec, fc)) << 4
+                              | LaneMask64(_mm_andnot_si128(ed, fd)) << 6;
+            uint32_t nAlt = BitCount16(altLanes);
+            altMatched += nAlt;
+            matched    += 8 - nAlt;
+            continue;
+        }
+
+        for (int k = 0; k < 8; k++)
+        {
+            uint64_t p = px[i + k];
+            if      ((p & rgbMask) == expected) matched++;
+            else if ((p & rgbMask) == alt)      altMatched++;
+            else Mismatch16(hist, p, lut, expectedCode, stats);
+        }
+    }
+#endif
+
+    for (; i < n; i++)
+    {
+        uint64_t p = px[i];
+        if      ((p & rgbMask) == expected) matched++;
+        else if ((p & rgbMask) == alt)      altMatched++;
+        else Mismatch16(hist, p, lut, expectedCode, stats);
+    }
+
+    if (stats) stats->pixels += (uint64_t)n;
+    if (stats) stats->ditherPixels += altMatched;
+    RecordMatches(hist, matched, expectedCode, stats);
+    RecordMatches(hist, altMatched, altCode, stats);
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// AnalyzeFrameCodes
+// ---------------------------------------------------------------------------
+
+bool AnalyzeFrameCodes(const FrameView& frame, const PatternParams& params, CodeAnalysis& out)
+{
+    if (!frame.data || frame.width <= 0 || frame.height <= 0) return false;
+    if (frame.width != params.width || frame.height != params.height) return false;
+    if ((int)frame.format != params.outputMode || params.numBars < 1) return false;
+
+    const bool     isPQ = (frame.format == FRAME_R10G10B10A2);
+    const uint16_t* lut = isPQ ? nullptr : HalfToPQCodeTable();
+
+    // Expected texels (alpha masked) and their PQ-domain codes; dithered bars
+    // may also carry their upper dither code
+    const bool dithered = isPQ && params.dither;
+    std::vector<uint64_t> barTexel(params.numBars), barAltTexel(params.numBars);
+    std::vector<uint32_t> barCode(params.numBars), barAltCode(params.numBars);
+    std::vector<PatternDither> barDither(params.numBars);
+    for (int b = 0; b < params.numBars; b++)
+    {
+        float nits = PatternBarNits(params, b);
+        if (dithered)
+        {
+            barDither[b]   = PatternDitherCodes(nits);
+            barCode[b]     = barDither[b].lo;
+            barAltCode[b]  = barDither[b].hi;
+            barTexel[b]    = PatternPackCode10(barCode[b]) & 0x3FFFFFFFu;
+            barAltTexel[b] = PatternPackCode10(barAltCode[b]) & 0x3FFFFFFFu;
+        }
+        else if (isPQ)
+        {
+            barTexel[b]    = PatternPackR10G10B10A2(nits) & 0x3FFFFFFFu;
+            barCode[b]     = PatternPQCode(nits);
+            barAltTexel[b] = barTexel[b];
+            barAltCode[b]  = barCode[b];
+        }
+        else
+        {
+            barTexel[b]    = PatternPackRGBA16F(nits) & 0x0000FFFFFFFFFFFFull;
+            barCode[b]     = lut[(uint16_t)barTexel[b]];
+            barAltTexel[b] = barTexel[b];
+            barAltCode[b]  = barCode[b];
+        }
+    }
+    const uint32_t labelCode = isPQ
+        ? PatternPQCode(params.labelNits)
+        : lut[FloatToHalf(params.labelNits / 80.0f)];
+
+    const int labelW = (frame.width < PATTERN_LABEL_W) ? frame.width : PATTERN_LABEL_W;
+    const int barW   = frame.width - labelW;
+
+    // Each worker owns a private histogram and per-bar stats
+    const int workers = ParallelWorkerCount(frame.height, 64);
+    std::vector<WorkerState> states(workers);
+
+    ParallelForBands(frame.height, workers, [&](int w, int y0, int y1)
+    {
+        WorkerState& st = states[w];
+        memset(st.hist, 0, sizeof(st.hist));
+        st.bars.resize(params.numBars);
+        for (auto& s : st.bars) ResetStats(s);
+        ResetStats(st.sep);
+
+        for (int y = y0; y < y1; y++)
+        {
+            const uint8_t* row = (const uint8_t*)frame.data + (size_t)y * frame.rowPitch;
+            PatternRow info = PatternClassifyRow(params, y);
+
+            if (isPQ)
+            {
+                const uint32_t* px = (const uint32_t*)row;
+                if (info.isSep)
+                {
+                    ScanRun10(px, frame.width, 0, 0, 0, 0, st.hist, &st.sep);
+                }
+                else
+                {
+                    ScanRun10(px, labelW, 0, 0, 0, 0, st.hist, nullptr);
+                    ScanRun10(px + labelW, barW, (uint32_t)barTexel[info.barIdx], barCode[info.barIdx],
+                        (uint32_t)barAltTexel[info.barIdx], barAltCode[info.barIdx], st.hist, &st.bars[info.barIdx]);
+                }
+            }
+            else
+            {
+                const uint64_t* px = (const uint64_t*)row;
+                if (info.isSep)
+                {
+                    ScanRun16(px, frame.width, 0, 0, 0, 0, lut, st.hist, &st.sep);
+                }
+                else
+                {
+                    ScanRun16(px, labelW, 0, 0, 0, 0, lut, st.hist, nullptr);
+                    ScanRun16(px + labelW, barW, barTexel[info.barIdx], barCode[info.barIdx],
+                        barAltTexel[info.barIdx], barAltCode[info.barIdx], lut, st.hist, &st.bars[info.barIdx]);
+                }
+            }
+        }
+    });
+
+    // Merge
+    memset(out.histogram, 0, sizeof(out.histogram));
+    std::vector<RunStats> bars(params.numBars);
+    for (auto& s : bars) ResetStats(s);
+    RunStats sep;
+    ResetStats(sep);
+
+    for (const WorkerState& st : states)
+    {
+        for (int c = 0; c < 3; c++)
+            for (int i = 0; i < PQ_CODE_BINS; i++)
+                out.histogram[c][i] += st.hist[c][i];
+        for (int b = 0; b < params.numBars; b++)
+            MergeStats(bars[b], st.bars[b]);
+        MergeStats(sep, st.sep);
+    }
+
+    out.pixels              = (uint64_t)frame.width * (uint64_t)frame.height;
+    out.dithered            = dithered;
+    out.unexpectedBarPixels = 0;
+    out.unexpectedSepPixels = sep.unexpected;
+    out.collapsedBars       = 0;
+    out.bars.resize(params.numBars);
+
+    for (int b = 0; b < params.numBars; b++)
+    {
+        BarCodeReport& r = out.bars[b];
+        r.barIdx       = b;
+        r.nits         = PatternBarNits(params, b);
+        r.expectedCode = barCode[b];
+        r.ditherCode   = dithered ? barAltCode[b] : barCode[b];
+        r.ditherShare  = dithered ? (double)barDither[b].upper : 0.0;
+        r.measuredShare = bars[b].pixels ? (double)bars[b].ditherPixels / (double)bars[b].pixels : 0.0;
+        r.pixels       = bars[b].pixels;
+        r.unexpected   = bars[b].unexpected;
+        r.minCode      = bars[b].pixels ? bars[b].minCode : barCode[b];
+        r.maxCode      = bars[b].pixels ? bars[b].maxCode : barCode[b];
+        r.maxDeviation = bars[b].maxDeviation;
+        r.meanCode     = bars[b].pixels ? (double)bars[b].codeSum / (3.0 * (double)bars[b].pixels) : 0.0;
+
+        out.unexpectedBarPixels += r.unexpected;
+        // A dithered bar only collapses if its whole dither matches the previous bar's
+        bool collapsed = (b > 0 && barCode[b] == barCode[b - 1]);
+        if (collapsed && dithered)
+            collapsed = (barDither[b].hi == barDither[b - 1].hi && barDither[b].upper == barDither[b - 1].upper);
+        if (collapsed) out.collapsedBars++;
+    }
+
+    // Any populated bin outside the set the pattern can emit is unexpected
+    std::vector<bool> allowed(PQ_CODE_BINS, false);
+    allowed[0]         = true;
+    allowed[labelCode] = true;
+    for (uint32_t code : barCode) allowed[code] = true;
+    if (dithered)
+        for (uint32_t code : barAltCode) allowed[code] = true;
+
+    out.unexpectedCodes.clear();
+    for (int c = 0; c < 3; c++)
+        for (uint32_t i = 0; i < (uint32_t)PQ_CODE_BINS; i++)
+            if (out.histogram[c][i] && !allowed[i])
+                out.unexpectedCodes.push_back({ c, i, out.histogram[c][i] });
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// FormatCodeAnalysis
+// ---------------------------------------------------------------------------
+
+std::string FormatCodeAnalysis(const CodeAnalysis& a, int maxLines)
+{
+    std::string s;
+    char line[160];
+
+    snprintf(line, sizeof(line),
+        "Pixels: %llu\nOff-code bar pixels: %llu\nOff-code separator pixels: %llu\n"
+        "Unexpected codes: %zu\nBars collapsed onto previous code: %d\n\n",
+        (unsigned long long)a.pixels,
+        (unsigned long long)a.unexpectedBarPixels,
+        (unsigned long long)a.unexpectedSepPixels,
+        a.unexpectedCodes.size(),
+        a.collapsedBars);
+    s += line;
+
+    if (a.dithered)
+        s += "Bar  Nits      Lo/Hi      Share want/got  Mean      Off-code\n";
+    else
+        s += "Bar  Nits      Code  Min   Max   MaxDev  Mean      Off-code\n";
+    int lines = 0;
+    for (const BarCodeReport& r : a.bars)
+    {
+        if (lines++ >= maxLines) { s += "...\n"; break; }
+        if (a.dithered)
+            snprintf(line, sizeof(line), "%-4d %-9.5f %4u/%-5u %.3f/%-9.3f %-9.3f %llu\n",
+                r.barIdx, r.nits, r.expectedCode, r.ditherCode, r.ditherShare, r.measuredShare,
+                r.meanCode, (unsigned long long)r.unexpected);
+        else
+            snprintf(line, sizeof(line), "%-4d %-9.5f %-5u %-5u %-5u %-7d %-9.3f %llu\n",
+                r.barIdx, r.nits, r.expectedCode, r.minCode, r.maxCode,
+                r.maxDeviation, r.meanCode, (unsigned long long)r.unexpected);
+        s += line;
+    }
+
+    if (!a.unexpectedCodes.empty())
+    {
+        s += "\nUnexpected codes (channel code count):\n";
+        lines = 0;
+        for (const UnexpectedCode& u : a.unexpectedCodes)
+        {
+            if (lines++ >= maxLines) { s += "...\n"; break; }
+            snprintf(line, sizeof(line), "%c %u %llu\n",
+                "RGB"[u.channel], u.code, (unsigned long long)u.count);
+            s += line;
+        }
+    }
+
+    return s;
+}
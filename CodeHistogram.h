@@ -0,0 +1,63 @@
+#pragma once
+
+// ---------------------------------------------------------------------------
+// CodeHistogram
+//
+// Verifies that a captured frame carries exactly the codes the pattern asked
+// for. Builds a per-channel histogram in the 10-bit PQ code domain (FP16
+// frames are mapped through the scRGB -> PQ conversion a compositor applies),
+// flags any code that the pattern never emits, and reports per-bar deviations
+// from the expected code. Blue-noise dithered HDR10 frames may carry either
+// of a bar's two dither codes; the report then compares the share of pixels
+// on the upper code with the share the dither asked for.
+//
+// Rows are split across worker threads, each with a private histogram; runs
+// of pixels that match the expected texel are confirmed with SSE2 compares and
+// binned in bulk, so only off-code pixels take the scalar unpack path.
+// ---------------------------------------------------------------------------
+
+#include "PatternCore.h"
+
+#include <string>
+#include <vector>
+
+struct BarCodeReport
+{
+    int      barIdx;
+    float    nits;
+    uint32_t expectedCode;  // 10-bit PQ code the bar should carry (lower code when dithered)
+    uint32_t ditherCode;    // upper dither code; == expectedCode when not dithered
+    double   ditherShare;   // share of pixels the dither puts on ditherCode
+    double   measuredShare; // share actually found on ditherCode
+    uint64_t pixels;        // bar-area pixels scanned (label column and separators excluded)
+    uint64_t unexpected;    // pixels whose texel differs from the expected one
+    uint32_t minCode;
+    uint32_t maxCode;
+    int      maxDeviation;  // largest |code - expectedCode| over all channels
+    double   meanCode;      // average over R, G and B
+};
+
+struct UnexpectedCode
+{
+    int      channel;       // 0 = R, 1 = G, 2 = B
+    uint32_t code;
+    uint64_t count;
+};
+
+struct CodeAnalysis
+{
+    uint64_t                    histogram[3][PQ_CODE_BINS];
+    std::vector<BarCodeReport>  bars;
+    std::vector<UnexpectedCode> unexpectedCodes;    // codes outside {black, label, bars}
+    uint64_t                    pixels;
+    bool                        dithered;
+    uint64_t                    unexpectedBarPixels;
+    uint64_t                    unexpectedSepPixels;
+    int                         collapsedBars;      // bars sharing a code with the previous bar
+};
+
+// Returns false if the frame and parameters do not describe the same image.
+bool AnalyzeFrameCodes(const FrameView& frame, const PatternParams& params, CodeAnalysis& out);
+
+// Human readable summary, truncated to `maxLines` bar / code lines.
+std::string FormatCodeAnalysis(const CodeAnalysis& analysis, int maxLines = 24);
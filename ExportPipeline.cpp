@@ -0,0 +1,328 @@
+#include "ExportPipeline.h"
+#include "BoundedQueue.h"
+#include "ImageEncode.h"
+#include "PatternRenderer.h"
+#include "RenderPlan.h"
+#include "SpanFrame.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// ---------------------------------------------------------------------------
+// File output
+// ---------------------------------------------------------------------------
+
+#ifdef _WIN32
+
+bool WriteFileMapped(const std::string& path, const uint8_t* data, size_t size)
+{
+    if (size == 0) return WriteFileBatched(path, data, size, 1);
+
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr,
+        CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    // Creating the mapping at full size extends (preallocates) the file
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE,
+        (DWORD)((uint64_t)size >> 32), (DWORD)size, nullptr);
+    bool ok = false;
+    if (mapping)
+    {
+        void* view = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size);
+        if (view)
+        {
+            memcpy(view, data, size);
+            ok = UnmapViewOfFile(view) != 0;
+        }
+        CloseHandle(mapping);
+    }
+    CloseHandle(file);
+    return ok;
+}
+
+bool WriteFileBatched(const std::string& path, const uint8_t* data, size_t size, size_t batchBytes)
+{
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_WRITE, 0, nullptr,
+        CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    bool ok = true;
+    while (ok && size)
+    {
+        DWORD chunk = (DWORD)((size < batchBytes) ? size : batchBytes);
+        DWORD written = 0;
+        ok = WriteFile(file, data, chunk, &written, nullptr) && written == chunk;
+        data += chunk;
+        size -= chunk;
+    }
+    CloseHandle(file);
+    return ok;
+}
+
+#else
+
+bool WriteFileMapped(const std::string& path, const uint8_t* data, size_t size)
+{
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+    if (size == 0) return close(fd) == 0;
+
+    // Reserve the blocks up front so the copy never hits ENOSPC as SIGBUS
+    bool ok = posix_fallocate(fd, 0, (off_t)size) == 0;
+    if (ok)
+    {
+        void* view = mmap(nullptr, size, PROT_WRITE, MAP_SHARED, fd, 0);
+        ok = (view != MAP_FAILED);
+        if (ok)
+        {
+            memcpy(view, data, size);
+            ok = munmap(view, size) == 0;
+        }
+    }
+    return (close(fd) == 0) && ok;
+}
+
+bool WriteFileBatched(const std::string& path, const uint8_t* data, size_t size, size_t batchBytes)
+{
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+
+    bool ok = true;
+    while (ok && size)
+    {
+        size_t chunk = (size < batchBytes) ? size : batchBytes;
+        ssize_t n = write(fd, data, chunk);
+        if (n < 0 && errno == EINTR) continue;     // interrupted before writing anything
+        ok = (n > 0);
+        if (ok)
+        {
+            data += n;
+            size -= (size_t)n;
+        }
+    }
+    return (close(fd) == 0) && ok;
+}
+
+#endif
+
+// ---------------------------------------------------------------------------
+// Pipeline
+// ---------------------------------------------------------------------------
+
+namespace
+{
+
+typedef std::chrono::steady_clock Clock;
+
+struct RenderedItem
+{
+    int        job = -1;
+    FrameLease frame;
+};
+
+struct EncodedItem
+{
+    int                  job = -1;
+    std::vector<uint8_t> bytes;
+};
+
+double Seconds(Clock::time_point a, Clock::time_point b)
+{
+    return std::chrono::duration<double>(b - a).count();
+}
+
+// Per-stage bookkeeping shared by that stage's workers
+struct StageState
+{
+    std::mutex       mutex;
+    ExportStageStats stats = {};
+    std::atomic<int> active{ 0 };
+
+    void Merge(uint64_t items, double busy, uint64_t stalls)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stats.items       += items;
+        stats.busySeconds += busy;
+        stats.stalls      += stalls;
+    }
+};
+
+} // namespace
+
+ExportConfig DefaultExportConfig()
+{
+    int hw = (int)std::thread::hardware_concurrency();
+    if (hw < 1) hw = 1;
+
+    ExportConfig c;
+    c.renderWorkers   = 1;
+    c.encodeWorkers   = (hw > 3) ? hw - 2 : 1;
+    c.writeWorkers    = 1;
+    c.queueDepth      = 4;
+    c.deflateWorkers  = 1;
+    c.chunkRows       = 64;
+    c.encoding        = EXPORT_ENCODE_IMAGE;
+    c.writeMode       = EXPORT_WRITE_MAPPED;
+    c.writeBatchBytes = 8u << 20;
+    return c;
+}
+
+bool RunExportPipeline(const std::vector<ExportJob>& jobs, const ExportConfig& config,
+    FramePool& pool, ExportStats& stats)
+{
+    const int renderWorkers = (config.renderWorkers > 0) ? config.renderWorkers : 1;
+    const int encodeWorkers = (config.encodeWorkers > 0) ? config.encodeWorkers : 1;
+    const int writeWorkers  = (config.writeWorkers  > 0) ? config.writeWorkers  : 1;
+    const size_t depth      = (config.queueDepth > 0) ? (size_t)config.queueDepth : 4;
+
+    BoundedQueue<RenderedItem>         rendered(depth);
+    BoundedQueue<EncodedItem>          encoded(depth);
+    BoundedQueue<std::vector<uint8_t>> spareBytes(depth + (size_t)encodeWorkers + (size_t)writeWorkers);
+
+    StageState renderStage, encodeStage, writeStage;
+    renderStage.active = renderWorkers;
+    encodeStage.active = encodeWorkers;
+    writeStage.active  = writeWorkers;
+
+    std::atomic<int>      nextJob{ 0 };
+    std::atomic<uint64_t> failures{ 0 };
+    std::atomic<uint64_t> bytesWritten{ 0 };
+
+    auto renderWorker = [&]()
+    {
+        uint64_t items = 0, stalls = 0;
+        double busy = 0.0;
+
+        for (;;)
+        {
+            int j = nextJob.fetch_add(1);
+            if (j >= (int)jobs.size()) break;
+
+            auto t0 = Clock::now();
+            const PatternParams& p = jobs[j].params;
+            RenderedItem item;
+            item.job   = j;
+            item.frame = pool.Acquire((FrameFormat)p.outputMode, p.width, p.height);
+            if (!item.frame)
+            {
+                failures++;
+                continue;
+            }
+            item.frame.HandOff(EXPORT_STAGE_RENDER);
+            if (jobs[j].plan)
+                RenderPlanFrame(*jobs[j].plan, item.frame.Data(), item.frame.RowPitch(), 1);
+            else
+                RenderPatternFrame(p, item.frame.Data(), item.frame.RowPitch(), 1);
+            busy += Seconds(t0, Clock::now());
+            items++;
+
+            stalls += rendered.Push(item);
+        }
+
+        renderStage.Merge(items, busy, stalls);
+        if (--renderStage.active == 0) rendered.Close();
+    };
+
+    auto encodeWorker = [&]()
+    {
+        uint64_t items = 0;
+        size_t   stalls = 0;
+        double   busy = 0.0;
+        EncodeOptions options = { config.deflateWorkers, config.chunkRows };
+
+        RenderedItem in;
+        while (rendered.Pop(in, &stalls))
+        {
+            auto t0 = Clock::now();
+            in.frame.HandOff(EXPORT_STAGE_ENCODE);
+
+            EncodedItem out;
+            out.job = in.job;
+            spareBytes.TryPop(out.bytes);   // reuse a buffer the writers returned
+
+            bool ok = (config.encoding == EXPORT_ENCODE_SPANS)
+                ? EncodeSpanFrame(in.frame.View(), out.bytes)
+                : EncodeFrame(in.frame.View(), options, out.bytes);
+            in.frame.Release();
+            busy += Seconds(t0, Clock::now());
+
+            if (!ok)
+            {
+                failures++;
+                continue;
+            }
+            items++;
+            stalls += encoded.Push(out);
+        }
+
+        encodeStage.Merge(items, busy, stalls);
+        if (--encodeStage.active == 0) encoded.Close();
+    };
+
+    auto writeWorker = [&]()
+    {
+        uint64_t items = 0;
+        size_t   stalls = 0;
+        double   busy = 0.0;
+
+        EncodedItem in;
+        while (encoded.Pop(in, &stalls))
+        {
+            auto t0 = Clock::now();
+            const ExportJob& job = jobs[in.job];
+            std::string path = job.basePath + ((config.encoding == EXPORT_ENCODE_SPANS)
+                ? ".pqs" : EncodedExtension((FrameFormat)job.params.outputMode));
+
+            bool ok = (config.writeMode == EXPORT_WRITE_MAPPED)
+                ? WriteFileMapped(path, in.bytes.data(), in.bytes.size())
+                : WriteFileBatched(path, in.bytes.data(), in.bytes.size(), config.writeBatchBytes);
+            busy += Seconds(t0, Clock::now());
+
+            if (ok)
+            {
+                items++;
+                bytesWritten += in.bytes.size();
+            }
+            else
+            {
+                failures++;
+            }
+
+            in.bytes.clear();
+            spareBytes.TryPush(in.bytes);   // dropped if the spare ring is full
+        }
+
+        writeStage.Merge(items, busy, stalls);
+    };
+
+    auto start = Clock::now();
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < renderWorkers; i++) threads.emplace_back(renderWorker);
+    for (int i = 0; i < encodeWorkers; i++) threads.emplace_back(encodeWorker);
+    for (int i = 0; i < writeWorkers;  i++) threads.emplace_back(writeWorker);
+    for (auto& t : threads) t.join();
+
+    stats.render       = renderStage.stats;
+    stats.encode       = encodeStage.stats;
+    stats.write        = writeStage.stats;
+    stats.wallSeconds  = Seconds(start, Clock::now());
+    stats.bytesWritten = bytesWritten;
+    stats.failures     = failures;
+    return stats.failures == 0;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+// ---------------------------------------------------------------------------
+// ExportPipeline
+//
+// Renders pattern sets to image files as three concurrent stages:
+//
+//   render (CPU reference) -> encode (PNG / EXR / .pqs) -> write (mmap or batched)
+//
+// Each stage has its own worker count and the stages are joined by bounded
+// lock-free queues, so throughput is set by the slowest stage rather than the
+// sum of all three. Frames move between stages as FramePool leases; encoded
+// byte buffers are recycled from the write stage back to the encoders.
+// ---------------------------------------------------------------------------
+
+#include "PatternCore.h"
+#include "FramePool.h"
+
+#include <string>
+#include <vector>
+
+// Frame lease owners (FrameLease::HandOff). Writers only see encoded bytes;
+// the frame goes back to the pool once it is encoded.
+enum ExportStage
+{
+    EXPORT_STAGE_RENDER = 1,
+    EXPORT_STAGE_ENCODE = 2
+};
+
+enum ExportWriteMode
+{
+    EXPORT_WRITE_MAPPED  = 0,   // preallocate, map and copy
+    EXPORT_WRITE_BATCHED = 1    // large write() / WriteFile() calls
+};
+
+class RenderPlan;
+
+enum ExportEncoding
+{
+    EXPORT_ENCODE_IMAGE = 0,    // PNG / EXR (ImageEncode.h)
+    EXPORT_ENCODE_SPANS = 1     // run-length .pqs (SpanFrame.h)
+};
+
+struct ExportJob
+{
+    PatternParams     params;           // with a plan: plan->Params()
+    std::string       basePath;         // extension is chosen by the encoder
+    const RenderPlan* plan = nullptr;   // compiled pattern, rendered instead of params
+};
+
+struct ExportConfig
+{
+    int             renderWorkers;
+    int             encodeWorkers;
+    int             writeWorkers;
+    int             queueDepth;         // slots in each inter-stage queue
+    int             deflateWorkers;     // threads per frame inside the encoder
+    int             chunkRows;          // PNG deflate chunk size
+    ExportEncoding  encoding;
+    ExportWriteMode writeMode;
+    size_t          writeBatchBytes;
+};
+
+struct ExportStageStats
+{
+    uint64_t items;
+    double   busySeconds;   // summed over the stage's workers
+    uint64_t stalls;        // waits on an empty input or a full output queue
+};
+
+struct ExportStats
+{
+    ExportStageStats render;
+    ExportStageStats encode;
+    ExportStageStats write;
+    double           wallSeconds;
+    uint64_t         bytesWritten;
+    uint64_t         failures;
+};
+
+ExportConfig DefaultExportConfig();
+
+// Returns false if any job failed to render, encode or write.
+bool RunExportPipeline(const std::vector<ExportJob>& jobs, const ExportConfig& config,
+    FramePool& pool, ExportStats& stats);
+
+bool WriteFileMapped(const std::string& path, const uint8_t* data, size_t size);
+bool WriteFileBatched(const std::string& path, const uint8_t* data, size_t size, size_t batchBytes);
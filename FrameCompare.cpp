@@ -0,0 +1,372 @@
+#include "FrameCompare.h"
+#include "Parallel.h"
+
+#include <cstdio>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define FRAMECMP_SSE2 1
+#endif
+
+// ---------------------------------------------------------------------------
+// Row hash
+// ---------------------------------------------------------------------------
+
+namespace
+{
+
+const uint64_t kPrime1 = 0x9E3779B185EBCA87ull;
+const uint64_t kPrime2 = 0xC2B2AE3D27D4EB4Full;
+
+const uint64_t kSecret[8] = {
+    0xBE4BA423396CFEB8ull, 0x1CAD21F72C81017Cull,
+    0xDB979083E96DD4DEull, 0x1F67B3B7A4A44072ull,
+    0x78E5C0CC4EE679CBull, 0x2172FFCC7DD05A82ull,
+    0x8E2443F7744608B8ull, 0x4C263A81E69035E0ull
+};
+
+inline uint64_t Fmix64(uint64_t k)
+{
+    k ^= k >> 33;
+    k *= 0xFF51AFD7ED558CCDull;
+    k ^= k >> 33;
+    k *= 0xC4CEB9FE1A85EC53ull;
+    k ^= k >> 33;
+    return k;
+}
+
+inline uint64_t Load64(const uint8_t* p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// acc[i ^ 1] += data[i]; acc[i] += lo32(key[i]) * hi32(key[i]), key = data ^ secret
+void AccumulateStripes(uint64_t acc[8], const uint8_t* p, size_t stripes)
+{
+#ifdef FRAMECMP_SSE2
+    __m128i a[4], sec[4];
+    for (int j = 0; j < 4; j++)
+    {
+        a[j]   = _mm_loadu_si128((const __m128i*)(acc + 2 * j));
+        sec[j] = _mm_loadu_si128((const __m128i*)(kSecret + 2 * j));
+    }
+
+    for (size_t s = 0; s < stripes; s++, p += 64)
+    {
+        for (int j = 0; j < 4; j++)
+        {
+            __m128i d    = _mm_loadu_si128((const __m128i*)(p + 16 * j));
+            __m128i k    = _mm_xor_si128(d, sec[j]);
+            __m128i kHi  = _mm_shuffle_epi32(k, _MM_SHUFFLE(0, 3, 0, 1));
+            __m128i prod = _mm_mul_epu32(k, kHi);
+            __m128i dSw  = _mm_shuffle_epi32(d, _MM_SHUFFLE(1, 0, 3, 2));
+            a[j] = _mm_add_epi64(a[j], _mm_add_epi64(prod, dSw));
+        }
+    }
+
+    for (int j = 0; j < 4; j++)
+        _mm_storeu_si128((__m128i*)(acc + 2 * j), a[j]);
+#else
+    for (size_t s = 0; s < stripes; s++, p += 64)
+    {
+        for (int i = 0; i < 8; i++)
+        {
+            uint64_t d = Load64(p + 8 * i);
+            uint64_t k = d ^ kSecret[i];
+            acc[i ^ 1] += d;
+            acc[i]     += (k & 0xFFFFFFFFull) * (k >> 32);
+        }
+    }
+#endif
+}
+
+uint64_t HashRow(const uint8_t* p, size_t len)
+{
+    uint64_t acc[8] = {
+        kPrime1, kPrime2, kSecret[0], kSecret[1],
+        kSecret[2], kSecret[3], kPrime2 ^ kPrime1, kPrime1 + kPrime2
+    };
+
+    size_t stripes = len / 64;
+    AccumulateStripes(acc, p, stripes);
+
+    size_t tail = len - stripes * 64;
+    if (tail)
+    {
+        uint8_t last[64] = {};
+        memcpy(last, p + stripes * 64, tail);
+        AccumulateStripes(acc, last, 1);
+    }
+
+    uint64_t h = (uint64_t)len * kPrime1;
+    for (int i = 0; i < 8; i++)
+        h = Fmix64(h + acc[i] * kPrime2 + (uint64_t)i);
+    return h;
+}
+
+// ---------------------------------------------------------------------------
+// Diff
+// ---------------------------------------------------------------------------
+
+struct DiffState
+{
+    uint64_t differing;
+    uint64_t overTolerance;
+    int      maxDelta;
+    int      firstX;
+    int      firstY;
+};
+
+inline int ChannelDelta(uint32_t a, uint32_t b)
+{
+    return (a > b) ? (int)(a - b) : (int)(b - a);
+}
+
+inline int PixelDelta10(uint32_t a, uint32_t b)
+{
+    int d = ChannelDelta(a & 0x3FFu, b & 0x3FFu);
+    int g = ChannelDelta((a >> 10) & 0x3FFu, (b >> 10) & 0x3FFu);
+    int c = ChannelDelta((a >> 20) & 0x3FFu, (b >> 20) & 0x3FFu);
+    if (g > d) d = g;
+    if (c > d) d = c;
+    return d;
+}
+
+inline int PixelDelta16(uint64_t a, uint64_t b, const uint16_t* lut)
+{
+    int d = 0;
+    for (int c = 0; c < 3; c++)
+    {
+        int cd = ChannelDelta(lut[(uint16_t)(a >> (16 * c))], lut[(uint16_t)(b >> (16 * c))]);
+        if (cd > d) d = cd;
+    }
+    // Raw mismatch that lands on the same PQ code still shows up
+    return d ? d : 1;
+}
+
+inline void RecordDelta(DiffState& st, int delta, int tolerance, int x, int y, uint16_t* heat)
+{
+    st.differing++;
+    if (delta > st.maxDelta) st.maxDelta = delta;
+    if (delta > tolerance)
+    {
+        if (st.overTolerance == 0) { st.firstX = x; st.firstY = y; }
+        st.overTolerance++;
+    }
+    if (heat) heat[x] = (uint16_t)delta;
+}
+
+// Compares one scanline. Identical 16-byte blocks are skipped with SSE2.
+template<typename Texel>
+void DiffRow(const Texel* a, const Texel* b, int width, Texel rgbMask, const uint16_t* lut,
+    int tolerance, int y, uint16_t* heat, DiffState& st)
+{
+    const int perBlock = 16 / (int)sizeof(Texel);
+    int x = 0;
+
+#ifdef FRAMECMP_SSE2
+    __m128i vMask;
+    if (sizeof(Texel) == 4) vMask = _mm_set1_epi32((int)(uint32_t)rgbMask);
+    else                    vMask = _mm_set_epi32(0x0000FFFF, -1, 0x0000FFFF, -1);
+
+    for (; x + perBlock <= width; x += perBlock)
+    {
+        __m128i va = _mm_and_si128(_mm_loadu_si128((const __m128i*)(a + x)), vMask);
+        __m128i vb = _mm_and_si128(_mm_loadu_si128((const __m128i*)(b + x)), vMask);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)) == 0xFFFF) continue;
+
+        for (int k = x; k < x + perBlock; k++)
+        {
+            if ((a[k] & rgbMask) == (b[k] & rgbMask)) continue;
+            int delta = (sizeof(Texel) == 4)
+                ? PixelDelta10((uint32_t)a[k], (uint32_t)b[k])
+                : PixelDelta16((uint64_t)a[k], (uint64_t)b[k], lut);
+            RecordDelta(st, delta, tolerance, k, y, heat);
+        }
+    }
+#endif
+
+    for (; x < width; x++)
+    {
+        if ((a[x] & rgbMask) == (b[x] & rgbMask)) continue;
+        int delta = (sizeof(Texel) == 4)
+            ? PixelDelta10((uint32_t)a[x], (uint32_t)b[x])
+            : PixelDelta16((uint64_t)a[x], (uint64_t)b[x], lut);
+        RecordDelta(st, delta, tolerance, x, y, heat);
+    }
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// HashFrame
+// ---------------------------------------------------------------------------
+
+uint64_t FrameHashSeed(int width, int height, FrameFormat format)
+{
+    return Fmix64(((uint64_t)width << 32) ^ ((uint64_t)height << 2) ^ (uint64_t)format);
+}
+
+uint64_t FrameHashRow(const void* row, size_t bytes)
+{
+    return HashRow((const uint8_t*)row, bytes);
+}
+
+uint64_t FrameHashFold(uint64_t h, uint64_t rowHash)
+{
+    return Fmix64((h * kPrime1) ^ rowHash);
+}
+
+uint64_t HashFrame(const FrameView& frame, int workers)
+{
+    if (!frame.data || frame.width <= 0 || frame.height <= 0) return 0;
+
+    const size_t rowBytes = (size_t)frame.width * FrameBytesPerPixel(frame.format);
+    std::vector<uint64_t> rowHash(frame.height);
+
+    if (workers <= 0) workers = ParallelWorkerCount(frame.height, 128);
+    ParallelForBands(frame.height, workers, [&](int, int y0, int y1)
+    {
+        for (int y = y0; y < y1; y++)
+            rowHash[y] = HashRow((const uint8_t*)frame.data + (size_t)y * frame.rowPitch, rowBytes);
+    });
+
+    uint64_t h = FrameHashSeed(frame.width, frame.height, frame.format);
+    for (int y = 0; y < frame.height; y++)
+        h = FrameHashFold(h, rowHash[y]);
+    return h;
+}
+
+// ---------------------------------------------------------------------------
+// DiffFrames
+// ---------------------------------------------------------------------------
+
+bool DiffFrames(const FrameView& a, const FrameView& b, const FrameDiffOptions& options, FrameDiff& out)
+{
+    if (!a.data || !b.data) return false;
+    if (a.width != b.width || a.height != b.height || a.format != b.format) return false;
+
+    out.width         = a.width;
+    out.height        = a.height;
+    out.differing     = 0;
+    out.overTolerance = 0;
+    out.maxDelta      = 0;
+    out.firstX        = -1;
+    out.firstY        = -1;
+    if (options.buildHeatmap) out.heat.assign((size_t)a.width * a.height, 0);
+    else                      out.heat.clear();
+
+    const bool      isPQ = (a.format == FRAME_R10G10B10A2);
+    const uint16_t* lut  = isPQ ? nullptr : HalfToPQCodeTable();
+
+    int workers = options.workers;
+    if (workers <= 0) workers = ParallelWorkerCount(a.height, 64);
+    std::vector<DiffState> states(workers);
+
+    ParallelForBands(a.height, workers, [&](int w, int y0, int y1)
+    {
+        DiffState& st = states[w];
+        st = DiffState{ 0, 0, 0, -1, -1 };
+
+        for (int y = y0; y < y1; y++)
+        {
+            const uint8_t* ra = (const uint8_t*)a.data + (size_t)y * a.rowPitch;
+            const uint8_t* rb = (const uint8_t*)b.data + (size_t)y * b.rowPitch;
+            uint16_t* heat = options.buildHeatmap ? out.heat.data() + (size_t)y * a.width : nullptr;
+
+            if (isPQ)
+                DiffRow<uint32_t>((const uint32_t*)ra, (const uint32_t*)rb, a.width,
+                    0x3FFFFFFFu, lut, options.tolerance, y, heat, st);
+            else
+                DiffRow<uint64_t>((const uint64_t*)ra, (const uint64_t*)rb, a.width,
+                    0x0000FFFFFFFFFFFFull, lut, options.tolerance, y, heat, st);
+        }
+    });
+
+    // Bands are in scanline order, so the first band reporting a failure
+    // holds the first failing pixel.
+    for (const DiffState& st : states)
+    {
+        out.differing     += st.differing;
+        out.overTolerance += st.overTolerance;
+        if (st.maxDelta > out.maxDelta) out.maxDelta = st.maxDelta;
+        if (out.firstY < 0 && st.firstY >= 0)
+        {
+            out.firstX = st.firstX;
+            out.firstY = st.firstY;
+        }
+    }
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Heatmaps
+// ---------------------------------------------------------------------------
+
+bool WriteDiffHeatmap(const FrameDiff& diff, const char* path)
+{
+    if (diff.heat.size() != (size_t)diff.width * diff.height) return false;
+
+    // Ramp scaled to the worst delta in this frame. Deltas reach 1023 codes,
+    // so rescale to 0..255 here rather than saturating; any difference stays
+    // at least 1 so it is not drawn as identical.
+    const int scale = diff.maxDelta > 0 ? diff.maxDelta : 1;
+    std::vector<uint8_t> heat(diff.heat.size());
+    for (size_t i = 0; i < heat.size(); i++)
+    {
+        int d = diff.heat[i];
+        heat[i] = d ? (uint8_t)((d * 255 + scale - 1) / scale) : 0;
+    }
+    return WriteHeatmap(heat.data(), diff.width, diff.height, 255, path);
+}
+
+bool WriteHeatmap(const uint8_t* heatMap, int width, int height, int maxValue, const char* path)
+{
+    FILE* f = fopen(path, "wb");
+    if (!f) return false;
+
+    fprintf(f, "P6\n%d %d\n255\n", width, height);
+
+    int scale = maxValue > 0 ? maxValue : 1;
+    std::vector<uint8_t> line((size_t)width * 3);
+
+    for (int y = 0; y < height; y++)
+    {
+        const uint8_t* heat = heatMap + (size_t)y * width;
+        for (int x = 0; x < width; x++)
+        {
+            uint8_t* rgb = &line[(size_t)x * 3];
+            if (!heat[x])
+            {
+                rgb[0] = rgb[1] = rgb[2] = 0;
+                continue;
+            }
+
+            int t = (heat[x] * 510) / scale;   // 0..510
+            if (t > 510) t = 510;
+            if (t <= 255)
+            {
+                // blue -> yellow
+                rgb[0] = (uint8_t)t;
+                rgb[1] = (uint8_t)t;
+                rgb[2] = (uint8_t)(255 - t);
+            }
+            else
+            {
+                // yellow -> red
+                rgb[0] = 255;
+                rgb[1] = (uint8_t)(510 - t);
+                rgb[2] = 0;
+            }
+        }
+        fwrite(line.data(), 1, line.size(), f);
+    }
+
+    bool ok = !ferror(f);
+    fclose(f);
+    return ok;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+// ---------------------------------------------------------------------------
+// FrameCompare
+//
+// Hashing and tolerance diffs for golden-image regression.
+//
+// Frame hashes are independent of row pitch and thread count: every scanline
+// is hashed on its own (SSE2 multiply-accumulate over 64-byte stripes, with an
+// identical scalar path elsewhere) and the row hashes are folded in order.
+//
+// Diffs measure per-channel distance in 10-bit PQ codes; FP16 frames are
+// mapped through the same scRGB -> PQ table CodeHistogram uses, so one
+// tolerance works for both output modes.
+// ---------------------------------------------------------------------------
+
+#include "PatternCore.h"
+
+#include <vector>
+
+uint64_t HashFrame(const FrameView& frame, int workers = 0);
+
+// Incremental form of HashFrame for producers that emit scanlines in order:
+//   h = FrameHashSeed(...); for each row: h = FrameHashFold(h, FrameHashRow(...));
+uint64_t FrameHashSeed(int width, int height, FrameFormat format);
+uint64_t FrameHashRow(const void* row, size_t bytes);
+uint64_t FrameHashFold(uint64_t h, uint64_t rowHash);
+
+struct FrameDiffOptions
+{
+    int  tolerance;     // largest accepted per-channel delta, in PQ codes
+    bool buildHeatmap;
+    int  workers;       // <= 0 = automatic
+};
+
+struct FrameDiff
+{
+    int      width;
+    int      height;
+    uint64_t differing;         // pixels whose RGB texel differs at all
+    uint64_t overTolerance;     // pixels with a channel delta > tolerance
+    int      maxDelta;
+    int      firstX;            // first pixel over tolerance, -1 if none
+    int      firstY;
+    std::vector<uint16_t> heat; // per-pixel max delta (0 = identical), if requested
+};
+
+// Returns false if the frames have different sizes or formats.
+bool DiffFrames(const FrameView& a, const FrameView& b, const FrameDiffOptions& options, FrameDiff& out);
+
+// Writes the heatmap as a binary PPM: black where identical, blue -> yellow
+// -> red with increasing delta, red being the frame's maxDelta.
+bool WriteDiffHeatmap(const FrameDiff& diff, const char* path);
+
+// Same ramp for any row-major map of 0..255 values; `maxValue` maps to red
+bool WriteHeatmap(const uint8_t* heat, int width, int height, int maxValue, const char* path);
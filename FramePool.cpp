@@ -0,0 +1,336 @@
+#include "FramePool.h"
+
+#include <cstring>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+// ---------------------------------------------------------------------------
+// OS memory
+// ---------------------------------------------------------------------------
+
+static const size_t POOL_ROW_ALIGN   = 64;
+static const size_t POOL_SMALL_PAGE  = 4096;
+static const size_t POOL_HUGE_PAGE   = 2u << 20;
+
+static size_t AlignUp(size_t v, size_t a)
+{
+    return (v + a - 1) & ~(a - 1);
+}
+
+#ifdef _WIN32
+
+static bool EnableLockMemoryPrivilege()
+{
+    HANDLE token = nullptr;
+    if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token))
+        return false;
+
+    TOKEN_PRIVILEGES tp = {};
+    tp.PrivilegeCount = 1;
+    tp.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+    bool ok = LookupPrivilegeValueW(nullptr, L"SeLockMemoryPrivilege", &tp.Privileges[0].Luid)
+        && AdjustTokenPrivileges(token, FALSE, &tp, 0, nullptr, nullptr)
+        && GetLastError() == ERROR_SUCCESS;
+    CloseHandle(token);
+    return ok;
+}
+
+static uint8_t* OsAlloc(size_t& size, bool wantHuge, bool& huge)
+{
+    huge = false;
+    if (wantHuge)
+    {
+        // Large pages need SeLockMemoryPrivilege; fall back silently without it
+        static const bool s_privileged = EnableLockMemoryPrivilege();
+        size_t large = GetLargePageMinimum();
+        if (s_privileged && large)
+        {
+            size_t hugeSize = AlignUp(size, large);
+            void* p = VirtualAlloc(nullptr, hugeSize, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+            if (p)
+            {
+                size = hugeSize;
+                huge = true;
+                return (uint8_t*)p;
+            }
+        }
+    }
+
+    size = AlignUp(size, POOL_SMALL_PAGE);
+    return (uint8_t*)VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+}
+
+static void OsFree(uint8_t* p, size_t)
+{
+    VirtualFree(p, 0, MEM_RELEASE);
+}
+
+uint64_t ProcessPageFaults()
+{
+    PROCESS_MEMORY_COUNTERS pmc = { sizeof(pmc) };
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) return 0;
+    return pmc.PageFaultCount;
+}
+
+#else
+
+static uint8_t* OsAlloc(size_t& size, bool wantHuge, bool& huge)
+{
+    huge = false;
+    size = AlignUp(size, wantHuge ? POOL_HUGE_PAGE : POOL_SMALL_PAGE);
+
+    // mmap only guarantees small-page alignment; for huge pages map one extra
+    // huge page and unmap the slack on either side of a 2 MB aligned base
+    size_t span = wantHuge ? size + POOL_HUGE_PAGE : size;
+    void* p = mmap(nullptr, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) return nullptr;
+
+    if (wantHuge)
+    {
+        uint8_t* raw  = (uint8_t*)p;
+        uint8_t* base = (uint8_t*)AlignUp((size_t)(uintptr_t)raw, POOL_HUGE_PAGE);
+        size_t   head = (size_t)(base - raw);
+        if (head) munmap(raw, head);
+        if (span - head > size) munmap(base + size, span - head - size);
+        p = base;
+    }
+
+#ifdef MADV_HUGEPAGE
+    // Transparent huge pages; harmless if THP is disabled
+    if (wantHuge && madvise(p, size, MADV_HUGEPAGE) == 0) huge = true;
+#endif
+    return (uint8_t*)p;
+}
+
+static void OsFree(uint8_t* p, size_t size)
+{
+    munmap(p, size);
+}
+
+uint64_t ProcessPageFaults()
+{
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) != 0) return 0;
+    return (uint64_t)ru.ru_minflt + (uint64_t)ru.ru_majflt;
+}
+
+#endif
+
+// ---------------------------------------------------------------------------
+// FrameLease
+// ---------------------------------------------------------------------------
+
+FrameLease::FrameLease(FrameLease&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+FrameLease& FrameLease::operator=(FrameLease&& other) noexcept
+{
+    if (this == &other) return *this;
+    Release();
+
+    m_pool     = other.m_pool;
+    m_data     = other.m_data;
+    m_rowPitch = other.m_rowPitch;
+    m_format   = other.m_format;
+    m_width    = other.m_width;
+    m_height   = other.m_height;
+    m_stage    = other.m_stage;
+
+    other.m_pool = nullptr;
+    other.m_data = nullptr;
+    return *this;
+}
+
+FrameView FrameLease::View() const
+{
+    FrameView v;
+    v.data     = m_data;
+    v.width    = m_width;
+    v.height   = m_height;
+    v.rowPitch = m_rowPitch;
+    v.format   = m_format;
+    return v;
+}
+
+void FrameLease::HandOff(int stage)
+{
+    m_stage = stage;
+    if (m_pool)
+    {
+        std::lock_guard<std::mutex> lock(m_pool->m_mutex);
+        m_pool->m_stats.handoffs++;
+    }
+}
+
+void FrameLease::Release()
+{
+    if (m_pool && m_data) m_pool->Return(*this);
+    m_pool = nullptr;
+    m_data = nullptr;
+}
+
+// ---------------------------------------------------------------------------
+// FramePool
+// ---------------------------------------------------------------------------
+
+FramePool::FramePool()
+    : FramePool(FramePoolConfig{ 256u << 20, true, true })
+{
+}
+
+FramePool::FramePool(const FramePoolConfig& config)
+    : m_config(config), m_stats()
+{
+}
+
+FramePool::~FramePool()
+{
+    // Outstanding leases would dangle; leak their chunks rather than crash
+    if (m_stats.outstanding == 0) Trim();
+}
+
+size_t FramePool::RowPitchFor(FrameFormat format, int width)
+{
+    return AlignUp((size_t)width * FrameBytesPerPixel(format), POOL_ROW_ALIGN);
+}
+
+FramePool::FreeList& FramePool::ListFor(FrameFormat format, int width, int height)
+{
+    for (FreeList& l : m_free)
+        if (l.format == format && l.width == width && l.height == height)
+            return l;
+
+    m_free.push_back(FreeList{ format, width, height, {} });
+    return m_free.back();
+}
+
+uint8_t* FramePool::Carve(size_t bytes)
+{
+    // Huge-page chunks start on a huge-page boundary (large-page allocations
+    // on Windows, the trimmed mapping in OsAlloc on Linux); rounding buffers to
+    // whole huge pages keeps every buffer carved from them on one as well
+    bytes = AlignUp(bytes, m_config.hugePages ? POOL_HUGE_PAGE : POOL_SMALL_PAGE);
+
+    Chunk* chunk = nullptr;
+    for (Chunk& c : m_chunks)
+    {
+        if (c.size - c.used >= bytes) { chunk = &c; break; }
+    }
+
+    if (!chunk)
+    {
+        size_t size = (bytes > m_config.arenaChunkBytes) ? bytes : m_config.arenaChunkBytes;
+        bool huge = false;
+        uint8_t* base = OsAlloc(size, m_config.hugePages, huge);
+        if (!base) return nullptr;
+
+        m_chunks.push_back(Chunk{ base, size, 0, huge });
+        m_stats.osAllocations++;
+        m_stats.osBytes += size;
+        if (huge) m_stats.hugePageChunks++;
+        chunk = &m_chunks.back();
+    }
+
+    uint8_t* p = chunk->base + chunk->used;
+    chunk->used += bytes;
+    m_stats.carves++;
+
+    if (m_config.prefault)
+    {
+        for (size_t off = 0; off < bytes; off += POOL_SMALL_PAGE)
+            p[off] = 0;
+    }
+    return p;
+}
+
+FrameLease FramePool::Acquire(FrameFormat format, int width, int height)
+{
+    FrameLease lease;
+    if (width <= 0 || height <= 0) return lease;
+
+    size_t pitch = RowPitchFor(format, width);
+    uint8_t* data = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.acquires++;
+
+        FreeList& list = ListFor(format, width, height);
+        if (!list.buffers.empty())
+        {
+            data = list.buffers.back();
+            list.buffers.pop_back();
+            m_stats.reuses++;
+        }
+        else
+        {
+            data = Carve(pitch * (size_t)height);
+            if (!data) return lease;
+        }
+        m_stats.outstanding++;
+    }
+
+    lease.m_pool     = this;
+    lease.m_data     = data;
+    lease.m_rowPitch = pitch;
+    lease.m_format   = format;
+    lease.m_width    = width;
+    lease.m_height   = height;
+    lease.m_stage    = 0;
+    return lease;
+}
+
+bool FramePool::Reserve(FrameFormat format, int width, int height, int count)
+{
+    if (width <= 0 || height <= 0) return false;
+
+    size_t bytes = RowPitchFor(format, width) * (size_t)height;
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    FreeList& list = ListFor(format, width, height);
+    for (int i = (int)list.buffers.size(); i < count; i++)
+    {
+        uint8_t* p = Carve(bytes);
+        if (!p) return false;
+        list.buffers.push_back(p);
+    }
+    return true;
+}
+
+void FramePool::Return(const FrameLease& lease)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ListFor(lease.m_format, lease.m_width, lease.m_height).buffers.push_back(lease.m_data);
+    m_stats.outstanding--;
+}
+
+bool FramePool::Trim()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_stats.outstanding != 0) return false;
+
+    for (Chunk& c : m_chunks) OsFree(c.base, c.size);
+    m_chunks.clear();
+    m_free.clear();
+    return true;
+}
+
+FramePoolStats FramePool::Stats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    FramePoolStats s = m_stats;
+    s.pageFaults = ProcessPageFaults();
+    return s;
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+// ---------------------------------------------------------------------------
+// FramePool
+//
+// Reusable full-frame buffers for batch and streaming rendering. Memory is
+// carved from large OS-level arena chunks (huge pages where the OS allows it,
+// pre-faulted on carve) and recycled through free lists keyed by format and
+// size, so a steady-state render loop performs no allocations and takes no
+// page faults.
+//
+// Buffers are handed out as move-only FrameLease objects; moving a lease from
+// one pipeline stage to the next is the ownership handoff, and the buffer
+// returns to the pool when the last owner drops it.
+// ---------------------------------------------------------------------------
+
+#include "PatternCore.h"
+
+#include <mutex>
+#include <vector>
+
+class FramePool;
+
+struct FramePoolConfig
+{
+    size_t arenaChunkBytes;     // minimum size of each OS allocation
+    bool   hugePages;           // request 2 MB / large pages when available
+    bool   prefault;            // touch every page when carving a buffer
+};
+
+struct FramePoolStats
+{
+    uint64_t osAllocations;     // arena chunks obtained from the OS
+    uint64_t osBytes;
+    uint64_t carves;            // buffers carved from an arena chunk
+    uint64_t acquires;
+    uint64_t reuses;            // acquires served from a free list
+    uint64_t handoffs;
+    uint64_t outstanding;       // leases currently alive
+    uint64_t hugePageChunks;
+    uint64_t pageFaults;        // process-wide, at the time of the query
+};
+
+class FrameLease
+{
+public:
+    FrameLease() = default;
+    FrameLease(FrameLease&& other) noexcept;
+    FrameLease& operator=(FrameLease&& other) noexcept;
+    FrameLease(const FrameLease&) = delete;
+    FrameLease& operator=(const FrameLease&) = delete;
+    ~FrameLease() { Release(); }
+
+    explicit operator bool() const { return m_data != nullptr; }
+
+    uint8_t*    Data() const        { return m_data; }
+    size_t      RowPitch() const    { return m_rowPitch; }
+    FrameFormat Format() const      { return m_format; }
+    int         Width() const       { return m_width; }
+    int         Height() const      { return m_height; }
+    int         Stage() const       { return m_stage; }
+    FrameView   View() const;
+
+    // Records that `stage` now owns the buffer. Call on the receiving side
+    // after moving the lease across a stage boundary.
+    void HandOff(int stage);
+
+    // Returns the buffer to its pool early
+    void Release();
+
+private:
+    friend class FramePool;
+
+    FramePool*  m_pool     = nullptr;
+    uint8_t*    m_data     = nullptr;
+    size_t      m_rowPitch = 0;
+    FrameFormat m_format   = FRAME_R10G10B10A2;
+    int         m_width    = 0;
+    int         m_height   = 0;
+    int         m_stage    = 0;
+};
+
+class FramePool
+{
+public:
+    FramePool();
+    explicit FramePool(const FramePoolConfig& config);
+    ~FramePool();
+
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+
+    // Returns an empty lease if memory could not be obtained
+    FrameLease Acquire(FrameFormat format, int width, int height);
+
+    // Carves `count` buffers up front so the first frames do not allocate
+    bool Reserve(FrameFormat format, int width, int height, int count);
+
+    // Frees every arena chunk. Only valid while no leases are outstanding.
+    bool Trim();
+
+    FramePoolStats Stats() const;
+
+    static size_t RowPitchFor(FrameFormat format, int width);
+
+private:
+    friend class FrameLease;
+
+    struct Chunk
+    {
+        uint8_t* base;
+        size_t   size;
+        size_t   used;
+        bool     huge;
+    };
+
+    struct FreeList
+    {
+        FrameFormat           format;
+        int                   width;
+        int                   height;
+        std::vector<uint8_t*> buffers;
+    };
+
+    uint8_t*  Carve(size_t bytes);
+    FreeList& ListFor(FrameFormat format, int width, int height);
+    void      Return(const FrameLease& lease);
+
+    FramePoolConfig       m_config;
+    mutable std::mutex    m_mutex;
+    std::vector<Chunk>    m_chunks;
+    std::vector<FreeList> m_free;
+    FramePoolStats        m_stats;
+};
+
+// Process-wide minor + major page fault count
+uint64_t ProcessPageFaults();
@@ -0,0 +1,338 @@
+#include "FrameSequencer.h"
+#include "PatternDesc.h"
+
+#include <cmath>
+#include <cstdio>
+
+// ---------------------------------------------------------------------------
+// Sequence builders
+// ---------------------------------------------------------------------------
+
+namespace
+{
+
+SequenceFrame MakeFrame(const PatternParams& base, NitsRange range, int step)
+{
+    SequenceFrame f;
+    f.params           = base;
+    f.params.startNits = range.startNits;
+    f.params.endNits   = range.endNits;
+    f.step             = step;
+    return f;
+}
+
+float LerpPQ(float a, float b, double t)
+{
+    double va = PatternPQEncode(a);
+    double vb = PatternPQEncode(b);
+    return (float)PatternPQDecode(va + t * (vb - va));
+}
+
+// Sequence frames are drawn by the shader in the toolbar's mode, with its
+// label and layout; only the range and bar count change per frame. Returns
+// the first keyword `d` sets that playback would ignore, or nullptr.
+const char* IgnoredSequenceKeyword(const PatternDesc& d)
+{
+    const PatternDesc    def = DefaultPatternDesc(d.name);
+    const PatternParams& p   = d.params;
+    const PatternLayout& l   = d.layout;
+
+    if (p.outputMode != def.params.outputMode)                          return "mode";
+    if (p.width != def.params.width || p.height != def.params.height)   return "size";
+    if (l.labels != def.layout.labels)                                  return "label";
+    if (p.labelNits != def.params.labelNits)                            return "label";
+    if (l.sepPx != def.layout.sepPx)                                    return "separator";
+    if (l.fontScale != def.layout.fontScale)                            return "font_scale";
+    if (l.labelChars != def.layout.labelChars)                          return "label_chars";
+    if (l.labelX != def.layout.labelX)                                  return "label_x";
+    if (d.spacing == BAR_SPACING_LIST)                                  return "levels";
+    if (d.spacing != BAR_SPACING_LINEAR)                                return "spacing";
+    return nullptr;
+}
+
+} // namespace
+
+std::vector<SequenceFrame> BuildFlickerSequence(const PatternParams& base, NitsRange a, NitsRange b,
+    int framesPerPhase, int cycles)
+{
+    std::vector<SequenceFrame> frames;
+    frames.reserve((size_t)(framesPerPhase > 0 ? framesPerPhase : 0) * 2 * (size_t)(cycles > 0 ? cycles : 0));
+    for (int c = 0; c < cycles; c++)
+    {
+        for (int f = 0; f < framesPerPhase; f++) frames.push_back(MakeFrame(base, a, 2 * c));
+        for (int f = 0; f < framesPerPhase; f++) frames.push_back(MakeFrame(base, b, 2 * c + 1));
+    }
+    return frames;
+}
+
+std::vector<SequenceFrame> BuildStepSequence(const PatternParams& base, NitsRange from, NitsRange to,
+    int holdFrames, int stepFrames)
+{
+    std::vector<SequenceFrame> frames;
+    for (int f = 0; f < holdFrames; f++) frames.push_back(MakeFrame(base, from, 0));
+    for (int f = 0; f < stepFrames; f++) frames.push_back(MakeFrame(base, to, 1));
+    return frames;
+}
+
+std::vector<SequenceFrame> BuildRampSweep(const PatternParams& base, NitsRange from, NitsRange to, int frames)
+{
+    std::vector<SequenceFrame> out;
+    for (int i = 0; i < frames; i++)
+    {
+        double t = (frames > 1) ? (double)i / (double)(frames - 1) : 0.0;
+        NitsRange r = { LerpPQ(from.startNits, to.startNits, t), LerpPQ(from.endNits, to.endNits, t) };
+        out.push_back(MakeFrame(base, r, i));
+    }
+    return out;
+}
+
+bool BuildLibrarySequence(const PatternLibrary& lib, int sequence, std::vector<SequenceFrame>& frames,
+    std::string* error)
+{
+    frames.clear();
+    if (sequence < 0 || sequence >= (int)lib.sequences.size())
+    {
+        if (error) *error = "no such sequence";
+        return false;
+    }
+
+    const PatternSequence& seq = lib.sequences[sequence];
+    for (size_t s = 0; s < seq.steps.size(); s++)
+    {
+        const PatternDesc& d = lib.patterns[seq.steps[s].pattern];
+        if (d.kind != PATTERN_BARS)
+        {
+            if (error) *error = seq.name + ": " + d.name + " is not a bar pattern";
+            frames.clear();
+            return false;
+        }
+        if (const char* keyword = IgnoredSequenceKeyword(d))
+        {
+            if (error) *error = seq.name + ": " + d.name + " sets " + keyword + ", which sequences do not support";
+            frames.clear();
+            return false;
+        }
+
+        SequenceFrame f = { d.params, (int)s };
+        frames.insert(frames.end(), (size_t)seq.steps[s].frames, f);
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// FrameSequencer
+// ---------------------------------------------------------------------------
+
+void FrameSequencer::Start(const std::vector<SequenceFrame>& frames, const PacingConfig& config)
+{
+    m_frames   = frames;
+    m_config   = config;
+    m_interval = (config.targetHz > 0.0) ? (int)lround(config.refreshHz / config.targetHz) : 1;
+    if (m_interval < 1) m_interval = 1;
+
+    m_records.resize(frames.size());
+    for (size_t i = 0; i < frames.size(); i++)
+        m_records[i] = FramePacingRecord{ (int)i, frames[i].step, -1, -1, 0.0 };
+
+    m_active  = !frames.empty();
+    m_started = false;
+    m_current = 0;
+}
+
+void FrameSequencer::Stop()
+{
+    m_active = false;
+}
+
+int FrameSequencer::FrameForVblank(int64_t vblank)
+{
+    if (!m_active) return -1;
+
+    const int count = (int)m_frames.size();
+    if (!m_started)
+    {
+        m_started     = true;
+        m_startVblank = vblank;
+        if (m_config.policy == PACING_HOLD_TIMELINE)
+        {
+            for (int i = 0; i < count; i++)
+                m_records[i].dueVblank = vblank + (int64_t)i * m_interval;
+        }
+        else
+        {
+            m_records[0].dueVblank = vblank;
+        }
+    }
+
+    if (m_config.policy == PACING_HOLD_TIMELINE)
+    {
+        // Frames whose slot has passed without a present are never shown
+        int64_t slot = (vblank - m_startVblank) / m_interval;
+        if (slot >= count)
+        {
+            m_active = false;
+            return -1;
+        }
+        return (int)slot;
+    }
+
+    // PACING_SHOW_ALL: advance once the current frame has had its interval,
+    // counted from when it was actually shown if that is known yet
+    const FramePacingRecord& cur = m_records[m_current];
+    int64_t anchor = (cur.shownVblank >= 0) ? cur.shownVblank : cur.dueVblank;
+    if (vblank >= anchor + m_interval)
+    {
+        if (++m_current >= count)
+        {
+            m_active = false;
+            return -1;
+        }
+        m_records[m_current].dueVblank = anchor + m_interval;
+    }
+    return m_current;
+}
+
+void FrameSequencer::Displayed(int index, int64_t vblank, double time)
+{
+    if (index < 0 || index >= (int)m_records.size()) return;
+    FramePacingRecord& r = m_records[index];
+    if (r.shownVblank >= 0) return;
+    r.shownVblank = vblank;
+    r.shownTime   = time;
+}
+
+PacingStats FrameSequencer::Stats() const
+{
+    PacingStats s = {};
+    s.frames           = m_records.size();
+    s.intervalVblanks  = m_interval;
+    s.targetIntervalMs = (m_config.refreshHz > 0.0) ? 1000.0 * m_interval / m_config.refreshHz : 0.0;
+
+    double sum = 0.0, sumSq = 0.0;
+    uint64_t intervals = 0;
+    const FramePacingRecord* prev = nullptr;
+
+    for (const FramePacingRecord& r : m_records)
+    {
+        if (r.shownVblank < 0)
+        {
+            s.dropped++;
+            prev = nullptr;
+            continue;
+        }
+
+        s.displayed++;
+        int64_t late = r.shownVblank - r.dueVblank;
+        if (r.dueVblank >= 0 && late > 0)
+        {
+            s.late++;
+            if (late > s.maxLateVblanks) s.maxLateVblanks = late;
+        }
+
+        // Interval between consecutive frames that were both shown
+        if (prev)
+        {
+            double ms = (r.shownTime - prev->shownTime) * 1000.0;
+            if (r.shownVblank - prev->shownVblank != m_interval) s.cadenceErrors++;
+            if (intervals == 0 || ms < s.minIntervalMs) s.minIntervalMs = ms;
+            if (intervals == 0 || ms > s.maxIntervalMs) s.maxIntervalMs = ms;
+            sum   += ms;
+            sumSq += ms * ms;
+            intervals++;
+        }
+        prev = &r;
+    }
+
+    if (intervals)
+    {
+        s.meanIntervalMs   = sum / (double)intervals;
+        double var         = sumSq / (double)intervals - s.meanIntervalMs * s.meanIntervalMs;
+        s.stddevIntervalMs = (var > 0.0) ? sqrt(var) : 0.0;
+    }
+    return s;
+}
+
+bool FrameSequencer::WriteCsv(const char* path) const
+{
+    FILE* f = fopen(path, "w");
+    if (!f) return false;
+
+    fprintf(f, "frame,step,start_nits,end_nits,due_vblank,shown_vblank,late_vblanks,shown_ms,interval_ms\n");
+    const FramePacingRecord* prev = nullptr;
+    for (const FramePacingRecord& r : m_records)
+    {
+        const PatternParams& p = m_frames[r.frame].params;
+        fprintf(f, "%d,%d,%.6f,%.6f,%lld,%lld,", r.frame, r.step, p.startNits, p.endNits,
+            (long long)r.dueVblank, (long long)r.shownVblank);
+
+        if (r.shownVblank < 0)
+        {
+            fprintf(f, ",,\n");
+            prev = nullptr;
+            continue;
+        }
+
+        fprintf(f, "%lld,%.3f,", (long long)(r.shownVblank - r.dueVblank), r.shownTime * 1000.0);
+        if (prev) fprintf(f, "%.3f", (r.shownTime - prev->shownTime) * 1000.0);
+        fprintf(f, "\n");
+        prev = &r;
+    }
+
+    bool ok = !ferror(f);
+    fclose(f);
+    return ok;
+}
+
+std::string FormatPacingStats(const PacingStats& s)
+{
+    char text[512];
+    snprintf(text, sizeof(text),
+        "Frames: %llu (%llu shown, %llu dropped)\n"
+        "Late frames: %llu, worst %lld vblank(s)\n"
+        "Cadence: %d vblank(s) = %.3f ms target, %llu intervals off target\n"
+        "Interval: mean %.3f ms, min %.3f, max %.3f, stddev %.3f\n",
+        (unsigned long long)s.frames, (unsigned long long)s.displayed, (unsigned long long)s.dropped,
+        (unsigned long long)s.late, (long long)s.maxLateVblanks,
+        s.intervalVblanks, s.targetIntervalMs, (unsigned long long)s.cadenceErrors,
+        s.meanIntervalMs, s.minIntervalMs, s.maxIntervalMs, s.stddevIntervalMs);
+    return text;
+}
+
+// ---------------------------------------------------------------------------
+// SimulatedVsyncClock
+// ---------------------------------------------------------------------------
+
+SimulatedVsyncClock::SimulatedVsyncClock(double refreshHz, double jitterMs, uint32_t seed)
+    : m_period(1.0 / refreshHz), m_jitter(jitterMs / 1000.0), m_seed(seed)
+{
+    // Keep vblanks ordered whatever the jitter
+    if (m_jitter > 0.45 * m_period) m_jitter = 0.45 * m_period;
+}
+
+double SimulatedVsyncClock::VblankTime(int64_t vblank) const
+{
+    double t = (double)vblank * m_period;
+    if (m_jitter > 0.0)
+    {
+        // Stateless hash so any vblank's time is reproducible on its own
+        uint32_t h = (uint32_t)vblank * 0x9E3779B1u ^ m_seed * 0x85EBCA77u;
+        h ^= h >> 15; h *= 0x2C1B3C6Du; h ^= h >> 12; h *= 0x297A2D39u; h ^= h >> 15;
+        t += ((double)h / 4294967295.0 * 2.0 - 1.0) * m_jitter;
+    }
+    return t;
+}
+
+int64_t SimulatedVsyncClock::NextVblank() const
+{
+    int64_t v = (int64_t)floor(m_now / m_period) - 1;
+    if (v < 0) v = 0;
+    while (VblankTime(v) <= m_now) v++;
+    return v;
+}
+
+int64_t SimulatedVsyncClock::Present()
+{
+    int64_t v = NextVblank();
+    m_now = VblankTime(v);
+    return v;
+}
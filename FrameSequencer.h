@@ -0,0 +1,175 @@
+#pragma once
+
+// ---------------------------------------------------------------------------
+// FrameSequencer
+//
+// Temporal test sequences (flicker, step response, ramp sweeps, pattern
+// library sequences) scheduled against a target cadence. Every frame's
+// parameters are built before the sequence starts; at run time the sequencer
+// only maps display vblanks to frame indices and records when each frame
+// actually reached the screen, so late, dropped and mistimed frames can be
+// reported afterwards.
+//
+// The core counts time in vblanks and is platform-neutral: Main.cpp feeds it
+// from DXGI frame statistics, and SimulatedVsyncClock drives it on any
+// platform for deterministic tests (see tools/SequenceSim.cpp).
+//
+// This header is pulled into Main.cpp after <windows.h>, so it avoids
+// std::min/std::max in inline code.
+// ---------------------------------------------------------------------------
+
+#include "PatternCore.h"
+
+#include <string>
+#include <vector>
+
+struct PatternLibrary;
+
+struct SequenceFrame
+{
+    PatternParams params;   // width/height are filled in by the renderer
+    int           step;     // phase / step this frame belongs to
+};
+
+struct NitsRange
+{
+    float startNits;
+    float endNits;
+};
+
+enum PacingPolicy
+{
+    // Frame i is due at vblank start + i * interval. A frame that cannot make
+    // its slot is dropped so later frames keep their timing.
+    PACING_HOLD_TIMELINE  = 0,
+
+    // Every frame is shown for a full interval; a late frame pushes the rest
+    // of the sequence back instead.
+    PACING_SHOW_ALL       = 1
+};
+
+struct PacingConfig
+{
+    double       refreshHz;     // display refresh rate
+    double       targetHz;      // sequence cadence; rounded to whole vblanks
+    PacingPolicy policy;
+};
+
+struct FramePacingRecord
+{
+    int     frame;
+    int     step;
+    int64_t dueVblank;
+    int64_t shownVblank;        // -1 = never displayed (dropped)
+    double  shownTime;          // seconds, clock-defined origin
+};
+
+struct PacingStats
+{
+    uint64_t frames;
+    uint64_t displayed;
+    uint64_t dropped;
+    uint64_t late;              // displayed after their due vblank
+    int64_t  maxLateVblanks;
+    uint64_t cadenceErrors;     // displayed frame intervals != target interval
+    int      intervalVblanks;   // target interval
+    double   targetIntervalMs;
+    double   meanIntervalMs;
+    double   minIntervalMs;
+    double   maxIntervalMs;
+    double   stddevIntervalMs;
+};
+
+// ---------------------------------------------------------------------------
+// Sequence builders
+// ---------------------------------------------------------------------------
+
+// Alternates between `a` and `b` every `framesPerPhase` frames, `cycles` times
+std::vector<SequenceFrame> BuildFlickerSequence(const PatternParams& base, NitsRange a, NitsRange b,
+    int framesPerPhase, int cycles);
+
+// Holds `from`, then switches to `to` on one frame boundary (step response)
+std::vector<SequenceFrame> BuildStepSequence(const PatternParams& base, NitsRange from, NitsRange to,
+    int holdFrames, int stepFrames);
+
+// Moves from `from` to `to` over `frames` frames, evenly in PQ signal
+std::vector<SequenceFrame> BuildRampSweep(const PatternParams& base, NitsRange from, NitsRange to, int frames);
+
+// Expands a library sequence (PatternDesc.h). Frames only carry the range and
+// bar count of each step, so patterns that set anything else (mode, size,
+// label, layout or non-linear spacing) are rejected rather than ignored.
+bool BuildLibrarySequence(const PatternLibrary& lib, int sequence, std::vector<SequenceFrame>& frames,
+    std::string* error);
+
+// ---------------------------------------------------------------------------
+// Sequencer
+// ---------------------------------------------------------------------------
+
+class FrameSequencer
+{
+public:
+    // Arms a sequence; the first FrameForVblank() call fixes the start vblank
+    void Start(const std::vector<SequenceFrame>& frames, const PacingConfig& config);
+    void Stop();
+
+    bool Active() const                         { return m_active; }
+    int  IntervalVblanks() const                { return m_interval; }
+    const SequenceFrame& Frame(int index) const { return m_frames[index]; }
+
+    // Index of the frame to submit for display at `vblank`, or -1 once the
+    // sequence is over. Calls must use non-decreasing vblanks.
+    int  FrameForVblank(int64_t vblank);
+
+    // Frame `index` reached the screen at `vblank`. Repeat presents of a frame
+    // already reported are ignored.
+    void Displayed(int index, int64_t vblank, double time);
+
+    const std::vector<FramePacingRecord>& Records() const { return m_records; }
+    PacingStats Stats() const;
+
+    // One CSV row per frame
+    bool WriteCsv(const char* path) const;
+
+private:
+    std::vector<SequenceFrame>     m_frames;
+    std::vector<FramePacingRecord> m_records;
+    PacingConfig                   m_config = {};
+    int                            m_interval = 1;
+    bool                           m_active   = false;
+    bool                           m_started  = false;
+    int64_t                        m_startVblank = 0;
+    int                            m_current  = 0;   // PACING_SHOW_ALL cursor
+};
+
+std::string FormatPacingStats(const PacingStats& s);
+
+// ---------------------------------------------------------------------------
+// Simulated display
+// ---------------------------------------------------------------------------
+
+// Deterministic stand-in for a flip-model swap chain presenting with sync
+// interval 1: vblank n happens at n / refreshHz plus optional seeded jitter,
+// and a present latches on the first vblank after the frame is ready.
+class SimulatedVsyncClock
+{
+public:
+    SimulatedVsyncClock(double refreshHz, double jitterMs = 0.0, uint32_t seed = 1);
+
+    double  Now() const             { return m_now; }
+    double  VblankTime(int64_t vblank) const;
+
+    // First vblank after Now()
+    int64_t NextVblank() const;
+
+    // Simulates CPU / GPU work
+    void    Advance(double seconds) { m_now += seconds; }
+
+    // Returns the vblank the frame was shown on; blocks (advances) until then
+    int64_t Present();
+
+private:
+    double   m_period;
+    double   m_jitter;
+    uint32_t m_seed;
+    double   m_now = 0.0;
+};
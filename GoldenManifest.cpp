@@ -0,0 +1,130 @@
+#include "GoldenManifest.h"
+
+#include <cstdio>
+#include <cstring>
+#include <cinttypes>
+
+// ---------------------------------------------------------------------------
+// Manifest
+// ---------------------------------------------------------------------------
+
+bool LoadGoldenManifest(const char* path, std::vector<GoldenEntry>& entries, std::string* error)
+{
+    FILE* f = fopen(path, "r");
+    if (!f)
+    {
+        if (error) *error = std::string("cannot open ") + path;
+        return false;
+    }
+
+    entries.clear();
+    char line[512];
+    int  lineNo = 0;
+
+    while (fgets(line, sizeof(line), f))
+    {
+        lineNo++;
+
+        char* hashMark = strchr(line, '#');
+        if (hashMark) *hashMark = '\0';
+
+        char name[128], mode[16], hash[32];
+        GoldenEntry e = {};
+        int n = sscanf(line, "%127s %d %d %d %15s %f %f %f %31s",
+            name, &e.params.width, &e.params.height, &e.params.numBars, mode,
+            &e.params.startNits, &e.params.endNits, &e.params.labelNits, hash);
+
+        if (n <= 0) continue;   // blank or comment
+
+        bool valid = (n == 9)
+            && e.params.width > 0 && e.params.height > 0
+            && e.params.numBars >= 1
+            && (strcmp(mode, "pq") == 0 || strcmp(mode, "scrgb") == 0);
+
+        if (valid)
+        {
+            e.params.outputMode = (strcmp(mode, "pq") == 0) ? FRAME_R10G10B10A2 : FRAME_RGBA16F;
+            e.name    = name;
+            e.hasHash = (strcmp(hash, "-") != 0);
+            e.hash    = 0;
+            if (e.hasHash)
+                valid = (sscanf(hash, "%" SCNx64, &e.hash) == 1);
+        }
+
+        if (!valid)
+        {
+            if (error)
+            {
+                char msg[64];
+                snprintf(msg, sizeof(msg), "%s:%d: malformed entry", path, lineNo);
+                *error = msg;
+            }
+            fclose(f);
+            return false;
+        }
+
+        entries.push_back(e);
+    }
+
+    fclose(f);
+    return true;
+}
+
+bool SaveGoldenManifest(const char* path, const std::vector<GoldenEntry>& entries)
+{
+    FILE* f = fopen(path, "w");
+    if (!f) return false;
+
+    fprintf(f, "# name width height bars mode start end label hash\n");
+    for (const GoldenEntry& e : entries)
+    {
+        char hash[32];
+        if (e.hasHash) snprintf(hash, sizeof(hash), "%016" PRIx64, e.hash);
+        else           snprintf(hash, sizeof(hash), "-");
+
+        // %.9g round-trips a float exactly
+        fprintf(f, "%s %d %d %d %s %.9g %.9g %.9g %s\n",
+            e.name.c_str(), e.params.width, e.params.height, e.params.numBars,
+            e.params.outputMode == FRAME_R10G10B10A2 ? "pq" : "scrgb",
+            e.params.startNits, e.params.endNits, e.params.labelNits, hash);
+    }
+
+    bool ok = !ferror(f);
+    fclose(f);
+    return ok;
+}
+
+std::vector<GoldenEntry> DefaultGoldenEntries()
+{
+    static const int   kSizes[][2]  = { { 1920, 1080 }, { 2560, 1440 }, { 3840, 2160 } };
+    static const int   kBars[]      = { 2, 10, 20, 50, 100 };
+    static const float kRanges[][2] = {
+        { 0.005f,  0.00248f },  // DEFAULT_START_NITS / DEFAULT_END_NITS
+        { 0.0f,    1.0f     },
+        { 100.0f,  10000.0f }
+    };
+
+    std::vector<GoldenEntry> entries;
+    for (const auto& size : kSizes)
+    for (int mode = 0; mode < 2; mode++)
+    for (int bars : kBars)
+    for (int r = 0; r < 3; r++)
+    {
+        GoldenEntry e = {};
+        e.params.width      = size[0];
+        e.params.height     = size[1];
+        e.params.numBars    = bars;
+        e.params.outputMode = mode;
+        e.params.startNits  = kRanges[r][0];
+        e.params.endNits    = kRanges[r][1];
+        e.params.labelNits  = 5.0f;
+        e.hasHash           = false;
+
+        char name[64];
+        snprintf(name, sizeof(name), "%dx%d_%s_b%d_r%d",
+            size[0], size[1], mode == 0 ? "pq" : "scrgb", bars, r);
+        e.name = name;
+        entries.push_back(e);
+    }
+    return entries;
+}
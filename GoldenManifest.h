@@ -0,0 +1,35 @@
+#pragma once
+
+// ---------------------------------------------------------------------------
+// GoldenManifest
+//
+// Plain-text list of pattern parameter sets and the frame hash each one is
+// expected to render to. One entry per line, '#' starts a comment:
+//
+//   # name        width height bars mode  start      end        label hash
+//   default_4k    3840  2160   20   pq    0.005      0.00248    5     1f0c...
+//
+// `mode` is "pq" or "scrgb"; `hash` is 16 hex digits, or "-" when unknown.
+//
+// Golden frames used for tolerance diffs are stored in the frames directory
+// as run-length span frames (<name>.pqs, see SpanFrame.h).
+// ---------------------------------------------------------------------------
+
+#include "PatternCore.h"
+
+#include <string>
+#include <vector>
+
+struct GoldenEntry
+{
+    std::string   name;
+    PatternParams params;
+    uint64_t      hash;
+    bool          hasHash;
+};
+
+bool LoadGoldenManifest(const char* path, std::vector<GoldenEntry>& entries, std::string* error);
+bool SaveGoldenManifest(const char* path, const std::vector<GoldenEntry>& entries);
+
+// Parameter grid used to seed a new manifest
+std::vector<GoldenEntry> DefaultGoldenEntries();
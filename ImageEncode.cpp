@@ -0,0 +1,618 @@
+#include "ImageEncode.h"
+#include "Parallel.h"
+
+#include <cstring>
+
+// ---------------------------------------------------------------------------
+// Checksums
+// ---------------------------------------------------------------------------
+
+namespace
+{
+
+const uint32_t ADLER_BASE = 65521;
+
+uint32_t Adler32(uint32_t adler, const uint8_t* p, size_t n)
+{
+    uint32_t a = adler & 0xFFFF;
+    uint32_t b = adler >> 16;
+    while (n)
+    {
+        size_t block = (n < 5552) ? n : 5552;   // largest n with no 32-bit overflow
+        n -= block;
+        while (block--)
+        {
+            a += *p++;
+            b += a;
+        }
+        a %= ADLER_BASE;
+        b %= ADLER_BASE;
+    }
+    return a | (b << 16);
+}
+
+// Checksum of A||B from checksums of A and B, as zlib's adler32_combine
+uint32_t Adler32Combine(uint32_t adler1, uint32_t adler2, size_t len2)
+{
+    uint32_t rem  = (uint32_t)(len2 % ADLER_BASE);
+    uint32_t sum1 = adler1 & 0xFFFF;
+    uint32_t sum2 = (uint32_t)(((uint64_t)rem * sum1) % ADLER_BASE);
+    sum1 += (adler2 & 0xFFFF) + ADLER_BASE - 1;
+    sum2 += (adler1 >> 16) + (adler2 >> 16) + ADLER_BASE - rem;
+    if (sum1 >= ADLER_BASE) sum1 -= ADLER_BASE;
+    if (sum1 >= ADLER_BASE) sum1 -= ADLER_BASE;
+    if (sum2 >= (ADLER_BASE << 1)) sum2 -= (ADLER_BASE << 1);
+    if (sum2 >= ADLER_BASE) sum2 -= ADLER_BASE;
+    return sum1 | (sum2 << 16);
+}
+
+const uint32_t* Crc32Table()
+{
+    struct Table
+    {
+        uint32_t t[256];
+        Table()
+        {
+            for (uint32_t i = 0; i < 256; i++)
+            {
+                uint32_t c = i;
+                for (int k = 0; k < 8; k++)
+                    c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                t[i] = c;
+            }
+        }
+    };
+    static const Table s_table;
+    return s_table.t;
+}
+
+uint32_t Crc32(uint32_t crc, const uint8_t* p, size_t n)
+{
+    const uint32_t* t = Crc32Table();
+    crc = ~crc;
+    while (n--) crc = t[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+// ---------------------------------------------------------------------------
+// Fixed-Huffman deflate
+// ---------------------------------------------------------------------------
+
+const uint16_t kLengthBase[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+const uint8_t kLengthExtra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+const uint16_t kDistBase[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+const uint8_t kDistExtra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+const int    HASH_BITS    = 15;
+const int    WINDOW_SIZE  = 32768;
+const size_t MAX_MATCH    = 258;
+const size_t MIN_MATCH    = 3;
+
+uint32_t ReverseBits(uint32_t v, int n)
+{
+    uint32_t r = 0;
+    for (int i = 0; i < n; i++) { r = (r << 1) | (v & 1); v >>= 1; }
+    return r;
+}
+
+// Bit-reversed fixed Huffman codes, ready for an LSB-first bit stream
+struct FixedCodes
+{
+    uint16_t lit[288];
+    uint8_t  litLen[288];
+    uint16_t dist[30];
+    uint8_t  lenSym[MAX_MATCH + 1];     // length -> index into kLengthBase
+
+    FixedCodes()
+    {
+        for (int s = 0; s < 288; s++)
+        {
+            uint32_t code; int len;
+            if      (s < 144) { code = 0x30 + s;          len = 8; }
+            else if (s < 256) { code = 0x190 + (s - 144); len = 9; }
+            else if (s < 280) { code = s - 256;           len = 7; }
+            else              { code = 0xC0 + (s - 280);  len = 8; }
+            lit[s]    = (uint16_t)ReverseBits(code, len);
+            litLen[s] = (uint8_t)len;
+        }
+        for (int d = 0; d < 30; d++)
+            dist[d] = (uint16_t)ReverseBits(d, 5);
+
+        int idx = 0;
+        for (size_t l = MIN_MATCH; l <= MAX_MATCH; l++)
+        {
+            while (idx < 28 && kLengthBase[idx + 1] <= l) idx++;
+            lenSym[l] = (uint8_t)idx;
+        }
+    }
+};
+
+const FixedCodes& Codes()
+{
+    static const FixedCodes s_codes;
+    return s_codes;
+}
+
+struct BitWriter
+{
+    std::vector<uint8_t>& out;
+    uint64_t bits  = 0;
+    int      count = 0;
+
+    explicit BitWriter(std::vector<uint8_t>& o) : out(o) {}
+
+    void Put(uint32_t v, int n)
+    {
+        bits |= (uint64_t)v << count;
+        count += n;
+        while (count >= 8)
+        {
+            out.push_back((uint8_t)bits);
+            bits >>= 8;
+            count -= 8;
+        }
+    }
+
+    void Align()
+    {
+        if (count > 0) out.push_back((uint8_t)bits);
+        bits  = 0;
+        count = 0;
+    }
+};
+
+inline uint32_t Load32(const uint8_t* p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline size_t MatchLength(const uint8_t* a, const uint8_t* b, size_t max)
+{
+    size_t n = 0;
+    while (n + 8 <= max)
+    {
+        uint64_t x, y;
+        memcpy(&x, a + n, 8);
+        memcpy(&y, b + n, 8);
+        if (x != y)
+        {
+            while (a[n] == b[n]) n++;
+            return n;
+        }
+        n += 8;
+    }
+    while (n < max && a[n] == b[n]) n++;
+    return n;
+}
+
+int DistanceCode(uint32_t dist)
+{
+    int lo = 0, hi = 29;
+    while (lo < hi)
+    {
+        int mid = (lo + hi + 1) / 2;
+        if (kDistBase[mid] <= dist) lo = mid; else hi = mid - 1;
+    }
+    return lo;
+}
+
+// Compresses one independent chunk as a single fixed-Huffman block. Non-final
+// chunks end with a sync flush so chunks can be concatenated byte-aligned.
+void DeflateChunk(const uint8_t* p, size_t n, bool final, std::vector<int32_t>& head,
+    std::vector<uint8_t>& out)
+{
+    const FixedCodes& fc = Codes();
+    BitWriter bw(out);
+
+    bw.Put(final ? 1 : 0, 1);
+    bw.Put(1, 2);                       // BTYPE = 01, fixed Huffman
+
+    head.assign((size_t)1 << HASH_BITS, -1);
+
+    size_t i = 0;
+    while (i < n)
+    {
+        size_t bestLen  = 0;
+        size_t bestDist = 0;
+        size_t maxLen   = (n - i < MAX_MATCH) ? n - i : MAX_MATCH;
+
+        if (maxLen >= MIN_MATCH)
+        {
+            // Runs (distance 1) dominate filtered test patterns
+            if (i > 0 && p[i] == p[i - 1])
+            {
+                bestLen  = MatchLength(p + i, p + i - 1, maxLen);
+                bestDist = 1;
+            }
+
+            if (bestLen < maxLen && maxLen >= 4)
+            {
+                uint32_t h = (Load32(p + i) * 2654435761u) >> (32 - HASH_BITS);
+                int32_t cand = head[h];
+                head[h] = (int32_t)i;
+                if (cand >= 0 && i - (size_t)cand <= (size_t)WINDOW_SIZE && i - (size_t)cand > 1)
+                {
+                    size_t len = MatchLength(p + i, p + cand, maxLen);
+                    if (len > bestLen)
+                    {
+                        bestLen  = len;
+                        bestDist = i - (size_t)cand;
+                    }
+                }
+            }
+        }
+
+        if (bestLen >= MIN_MATCH)
+        {
+            int li = fc.lenSym[bestLen];
+            int ls = 257 + li;
+            bw.Put(fc.lit[ls], fc.litLen[ls]);
+            if (kLengthExtra[li]) bw.Put((uint32_t)(bestLen - kLengthBase[li]), kLengthExtra[li]);
+
+            int di = DistanceCode((uint32_t)bestDist);
+            bw.Put(fc.dist[di], 5);
+            if (kDistExtra[di]) bw.Put((uint32_t)(bestDist - kDistBase[di]), kDistExtra[di]);
+
+            i += bestLen;
+        }
+        else
+        {
+            bw.Put(fc.lit[p[i]], fc.litLen[p[i]]);
+            i++;
+        }
+    }
+
+    bw.Put(fc.lit[256], fc.litLen[256]);    // end of block
+
+    if (!final)
+    {
+        // Empty stored block: byte-aligns the stream
+        bw.Put(0, 3);
+        bw.Align();
+        out.push_back(0x00);
+        out.push_back(0x00);
+        out.push_back(0xFF);
+        out.push_back(0xFF);
+    }
+    else
+    {
+        bw.Align();
+    }
+}
+
+void PutBE32(std::vector<uint8_t>& out, uint32_t v)
+{
+    out.push_back((uint8_t)(v >> 24));
+    out.push_back((uint8_t)(v >> 16));
+    out.push_back((uint8_t)(v >> 8));
+    out.push_back((uint8_t)v);
+}
+
+// Produces `count` pieces of raw data with produce(piece, raw), deflates them
+// in parallel and appends one zlib stream to `out`.
+template<typename Produce>
+void ZlibCompressPieces(int count, int workers, Produce&& produce, std::vector<uint8_t>& out)
+{
+    struct Piece
+    {
+        std::vector<uint8_t> deflated;
+        uint32_t             adler;
+        size_t               rawSize;
+    };
+    std::vector<Piece> pieces(count);
+
+    if (workers <= 0) workers = ParallelWorkerCount(count, 1);
+    ParallelForBands(count, workers, [&](int, int begin, int end)
+    {
+        std::vector<uint8_t> raw;
+        std::vector<int32_t> head;
+        for (int i = begin; i < end; i++)
+        {
+            raw.clear();
+            produce(i, raw);
+            pieces[i].rawSize = raw.size();
+            pieces[i].adler   = Adler32(1, raw.data(), raw.size());
+            DeflateChunk(raw.data(), raw.size(), i == count - 1, head, pieces[i].deflated);
+        }
+    });
+
+    out.push_back(0x78);    // CM = 8, CINFO = 7 (32K window)
+    out.push_back(0x01);    // FLEVEL = 0, FCHECK
+
+    uint32_t adler = 1;
+    for (int i = 0; i < count; i++)
+    {
+        out.insert(out.end(), pieces[i].deflated.begin(), pieces[i].deflated.end());
+        adler = (i == 0) ? pieces[i].adler : Adler32Combine(adler, pieces[i].adler, pieces[i].rawSize);
+    }
+    PutBE32(out, adler);
+}
+
+// ---------------------------------------------------------------------------
+// PNG
+// ---------------------------------------------------------------------------
+
+void PutPNGChunk(std::vector<uint8_t>& out, const char type[4], const uint8_t* data, size_t size)
+{
+    PutBE32(out, (uint32_t)size);
+    size_t start = out.size();
+    out.insert(out.end(), type, type + 4);
+    if (size) out.insert(out.end(), data, data + size);
+    PutBE32(out, Crc32(0, out.data() + start, size + 4));
+}
+
+// One PNG scanline (filter byte + 16-bit big-endian RGB). Rows identical to
+// the previous one use the Up filter, everything else Sub; both turn the
+// pattern's constant runs into zero bytes.
+void FilterPNGRow(const FrameView& frame, int y, std::vector<uint8_t>& raw)
+{
+    const size_t rowBytes = (size_t)frame.width * 4;
+    const uint8_t* src = (const uint8_t*)frame.data + (size_t)y * frame.rowPitch;
+
+    size_t start = raw.size();
+    raw.resize(start + 1 + (size_t)frame.width * 6);
+    uint8_t* dst = raw.data() + start;
+
+    if (y > 0 && memcmp(src, src - frame.rowPitch, rowBytes) == 0)
+    {
+        dst[0] = 2;
+        memset(dst + 1, 0, (size_t)frame.width * 6);
+        return;
+    }
+
+    dst[0] = 1;
+    const uint32_t* px = (const uint32_t*)src;
+    uint16_t prev[3] = { 0, 0, 0 };
+    uint8_t* o = dst + 1;
+    for (int x = 0; x < frame.width; x++)
+    {
+        uint32_t p = px[x];
+        for (int c = 0; c < 3; c++)
+        {
+            uint32_t code = (p >> (10 * c)) & 0x3FFu;
+            uint16_t v    = (uint16_t)((code << 6) | (code >> 4));
+            // Sub works on bytes, so no borrow between high and low byte
+            *o++ = (uint8_t)((v >> 8) - (prev[c] >> 8));
+            *o++ = (uint8_t)(v - prev[c]);
+            prev[c] = v;
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// OpenEXR
+// ---------------------------------------------------------------------------
+
+const int EXR_ZIP_LINES = 16;
+
+void PutLE32(std::vector<uint8_t>& out, uint32_t v)
+{
+    out.push_back((uint8_t)v);
+    out.push_back((uint8_t)(v >> 8));
+    out.push_back((uint8_t)(v >> 16));
+    out.push_back((uint8_t)(v >> 24));
+}
+
+void PutLE64(std::vector<uint8_t>& out, uint64_t v)
+{
+    PutLE32(out, (uint32_t)v);
+    PutLE32(out, (uint32_t)(v >> 32));
+}
+
+void PutAttr(std::vector<uint8_t>& out, const char* name, const char* type, const std::vector<uint8_t>& value)
+{
+    out.insert(out.end(), name, name + strlen(name) + 1);
+    out.insert(out.end(), type, type + strlen(type) + 1);
+    PutLE32(out, (uint32_t)value.size());
+    out.insert(out.end(), value.begin(), value.end());
+}
+
+void PutFloatLE(std::vector<uint8_t>& out, float f)
+{
+    uint32_t v;
+    memcpy(&v, &f, sizeof(v));
+    PutLE32(out, v);
+}
+
+// ZIP_COMPRESSION block: scanlines of B, G, R halves, then byte interleave
+// split and delta predictor, then zlib. Stored raw if that does not shrink it.
+void EncodeEXRBlock(const FrameView& frame, int y0, std::vector<uint8_t>& raw,
+    std::vector<uint8_t>& tmp, std::vector<uint8_t>& out)
+{
+    int y1 = (y0 + EXR_ZIP_LINES < frame.height) ? y0 + EXR_ZIP_LINES : frame.height;
+
+    size_t n = (size_t)(y1 - y0) * frame.width * 6;
+    raw.resize(n);
+    uint8_t* o = raw.data();
+    for (int y = y0; y < y1; y++)
+    {
+        const uint64_t* px = (const uint64_t*)((const uint8_t*)frame.data + (size_t)y * frame.rowPitch);
+        for (int c = 2; c >= 0; c--)    // channels sorted by name: B, G, R
+        {
+            for (int x = 0; x < frame.width; x++)
+            {
+                uint16_t h = (uint16_t)(px[x] >> (16 * c));
+                *o++ = (uint8_t)h;
+                *o++ = (uint8_t)(h >> 8);
+            }
+        }
+    }
+
+    tmp.resize(n);
+    {
+        uint8_t* t1 = tmp.data();
+        uint8_t* t2 = tmp.data() + (n + 1) / 2;
+        size_t i = 0;
+        for (; i + 1 < n; i += 2)
+        {
+            *t1++ = raw[i];
+            *t2++ = raw[i + 1];
+        }
+        if (i < n) *t1 = raw[i];
+    }
+    for (size_t i = n - 1; i > 0; i--)
+        tmp[i] = (uint8_t)((int)tmp[i] - (int)tmp[i - 1] + (128 + 256));
+
+    std::vector<uint8_t> packed;
+    ZlibCompress(tmp.data(), n, packed);
+
+    PutLE32(out, (uint32_t)y0);
+    if (packed.size() < n)
+    {
+        PutLE32(out, (uint32_t)packed.size());
+        out.insert(out.end(), packed.begin(), packed.end());
+    }
+    else
+    {
+        PutLE32(out, (uint32_t)n);
+        out.insert(out.end(), raw.begin(), raw.end());
+    }
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+void ZlibCompress(const uint8_t* data, size_t size, std::vector<uint8_t>& out)
+{
+    std::vector<int32_t> head;
+    out.push_back(0x78);
+    out.push_back(0x01);
+    DeflateChunk(data, size, true, head, out);
+    PutBE32(out, Adler32(1, data, size));
+}
+
+bool EncodePNG(const FrameView& frame, const EncodeOptions& options, std::vector<uint8_t>& out)
+{
+    if (frame.format != FRAME_R10G10B10A2 || frame.width <= 0 || frame.height <= 0) return false;
+
+    static const uint8_t kSignature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    out.clear();
+    out.insert(out.end(), kSignature, kSignature + 8);
+
+    std::vector<uint8_t> ihdr;
+    PutBE32(ihdr, (uint32_t)frame.width);
+    PutBE32(ihdr, (uint32_t)frame.height);
+    ihdr.push_back(16);     // bit depth
+    ihdr.push_back(2);      // RGB
+    ihdr.push_back(0);
+    ihdr.push_back(0);
+    ihdr.push_back(0);
+    PutPNGChunk(out, "IHDR", ihdr.data(), ihdr.size());
+
+    // BT.2020 primaries, SMPTE ST 2084 transfer, RGB, full range
+    static const uint8_t kCICP[4] = { 9, 16, 0, 1 };
+    PutPNGChunk(out, "cICP", kCICP, 4);
+
+    int chunkRows = (options.chunkRows > 0) ? options.chunkRows : 64;
+    int pieces    = (frame.height + chunkRows - 1) / chunkRows;
+
+    std::vector<uint8_t> idat;
+    ZlibCompressPieces(pieces, options.workers, [&](int piece, std::vector<uint8_t>& raw)
+    {
+        int y0 = piece * chunkRows;
+        int y1 = (y0 + chunkRows < frame.height) ? y0 + chunkRows : frame.height;
+        for (int y = y0; y < y1; y++) FilterPNGRow(frame, y, raw);
+    }, idat);
+
+    PutPNGChunk(out, "IDAT", idat.data(), idat.size());
+    PutPNGChunk(out, "IEND", nullptr, 0);
+    return true;
+}
+
+bool EncodeEXR(const FrameView& frame, const EncodeOptions& options, std::vector<uint8_t>& out)
+{
+    if (frame.format != FRAME_RGBA16F || frame.width <= 0 || frame.height <= 0) return false;
+
+    out.clear();
+    PutLE32(out, 20000630);     // magic
+    PutLE32(out, 2);            // version 2, single-part scanline
+
+    std::vector<uint8_t> v;
+    for (const char* name : { "B", "G", "R" })
+    {
+        v.push_back((uint8_t)name[0]);
+        v.push_back(0);
+        PutLE32(v, 1);          // HALF
+        v.push_back(0);         // pLinear
+        v.push_back(0); v.push_back(0); v.push_back(0);
+        PutLE32(v, 1);          // xSampling
+        PutLE32(v, 1);          // ySampling
+    }
+    v.push_back(0);
+    PutAttr(out, "channels", "chlist", v);
+
+    v.assign(1, 3);             // ZIP_COMPRESSION
+    PutAttr(out, "compression", "compression", v);
+
+    v.clear();
+    PutLE32(v, 0); PutLE32(v, 0);
+    PutLE32(v, (uint32_t)(frame.width - 1)); PutLE32(v, (uint32_t)(frame.height - 1));
+    PutAttr(out, "dataWindow", "box2i", v);
+    PutAttr(out, "displayWindow", "box2i", v);
+
+    v.assign(1, 0);             // INCREASING_Y
+    PutAttr(out, "lineOrder", "lineOrder", v);
+
+    v.clear(); PutFloatLE(v, 1.0f);
+    PutAttr(out, "pixelAspectRatio", "float", v);
+
+    v.clear(); PutFloatLE(v, 0.0f); PutFloatLE(v, 0.0f);
+    PutAttr(out, "screenWindowCenter", "v2f", v);
+
+    v.clear(); PutFloatLE(v, 1.0f);
+    PutAttr(out, "screenWindowWidth", "float", v);
+
+    out.push_back(0);           // end of header
+
+    // Blocks are independent; compress them in parallel
+    int blocks = (frame.height + EXR_ZIP_LINES - 1) / EXR_ZIP_LINES;
+    std::vector<std::vector<uint8_t>> encoded(blocks);
+
+    int workers = (options.workers > 0) ? options.workers : ParallelWorkerCount(blocks, 4);
+    ParallelForBands(blocks, workers, [&](int, int begin, int end)
+    {
+        std::vector<uint8_t> raw, tmp;
+        for (int b = begin; b < end; b++)
+            EncodeEXRBlock(frame, b * EXR_ZIP_LINES, raw, tmp, encoded[b]);
+    });
+
+    uint64_t offset = out.size() + (uint64_t)blocks * 8;
+    for (int b = 0; b < blocks; b++)
+    {
+        PutLE64(out, offset);
+        offset += encoded[b].size();
+    }
+    for (int b = 0; b < blocks; b++)
+        out.insert(out.end(), encoded[b].begin(), encoded[b].end());
+
+    return true;
+}
+
+bool EncodeFrame(const FrameView& frame, const EncodeOptions& options, std::vector<uint8_t>& out)
+{
+    return (frame.format == FRAME_R10G10B10A2)
+        ? EncodePNG(frame, options, out)
+        : EncodeEXR(frame, options, out);
+}
+
+const char* EncodedExtension(FrameFormat format)
+{
+    return (format == FRAME_R10G10B10A2) ? ".png" : ".exr";
+}
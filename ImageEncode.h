@@ -0,0 +1,35 @@
+#pragma once
+
+// ---------------------------------------------------------------------------
+// ImageEncode
+//
+// Self-contained PNG and OpenEXR writers for exported frames.
+//
+// Deflate is a small fixed-Huffman LZ77 encoder tuned for test patterns
+// (scanline filters turn bars into long zero runs). Large inputs are split
+// into independent chunks compressed in parallel and joined with sync
+// flushes, pigz-style, so one zlib stream is produced at multi-core speed.
+//
+//   HDR10 PQ frames   -> 16-bit RGB PNG tagged with cICP (BT.2020 / PQ)
+//   FP16 scRGB frames -> half-float RGB OpenEXR, ZIP compression
+// ---------------------------------------------------------------------------
+
+#include "PatternCore.h"
+
+#include <vector>
+
+struct EncodeOptions
+{
+    int workers;        // threads for chunked deflate, <= 0 = automatic
+    int chunkRows;      // scanlines per independently compressed chunk
+};
+
+// Appends a complete zlib stream for `size` bytes of `data`.
+void ZlibCompress(const uint8_t* data, size_t size, std::vector<uint8_t>& out);
+
+bool EncodePNG(const FrameView& frame, const EncodeOptions& options, std::vector<uint8_t>& out);
+bool EncodeEXR(const FrameView& frame, const EncodeOptions& options, std::vector<uint8_t>& out);
+
+// PNG for R10G10B10A2, EXR for RGBA16F
+bool EncodeFrame(const FrameView& frame, const EncodeOptions& options, std::vector<uint8_t>& out);
+const char* EncodedExtension(FrameFormat format);
@@ -13,6 +13,18 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cmath>
+#include <string>
+#include <vector>
+
+#include "PatternCore.h"
+#include "BarSchedule.h"
+#include "BlueNoise.h"
+#include "CodeHistogram.h"
+#include "PatternRenderer.h"
+#include "FrameCompare.h"
+#include "PrecisionCheck.h"
+#include "FrameSequencer.h"
+#include "PatternDesc.h"
 
 // ---------------------------------------------------------------------------
 // Embedded HLSL shaders
@@ -44,9 +56,19 @@ cbuffer TestParams : register(b0)
     int   numBars;
     int   outputMode;   // 0 = PQ direct, 1 = scRGB linear
     float labelNits;
-    float pad;
+    int   dither;       // 1 = blue-noise dither bars (HDR10 only)
+    float ditherPhase;  // temporal offset of the dither mask
+    int   barTable;     // 1 = bar luminances come from barNitsTable
+    float2 pad;
 };
 
+// 64x64 blue-noise thresholds (BlueNoiseMask()), tiled over the screen
+Texture2D<float> blueNoise : register(t0);
+static const int BLUE_NOISE_MASK = 63;
+
+// Per-bar luminances of a non-linear spacing schedule (BarSchedule.h)
+Buffer<float> barNitsTable : register(t1);
+
 // ---- 3x5 bitmap font for digits 0-9 ----
 // Each glyph packed into 15 bits: row0[14:12] row1[11:9] row2[8:6] row3[5:3] row4[2:0]
 // Within each 3-bit row: bit2=left, bit1=center, bit0=right.
@@ -150,6 +172,37 @@ float3 ApplyPQ(float3 Y)
     return pow(num / den, m2);
 }
 
+// ST.2084 PQ inverse: PQ [0,1] -> linear [0,1]
+float RemovePQ(float V)
+{
+    const float m1 = 0.1593017578125;
+    const float m2 = 78.84375;
+    const float c1 = 0.8359375;
+    const float c2 = 18.8515625;
+    const float c3 = 18.6875;
+
+    float Vm2 = pow(max(V, 0.0), 1.0 / m2);
+    float num = max(Vm2 - c1, 0.0);
+    return pow(num / (c2 - c3 * Vm2), 1.0 / m1);
+}
+
+// Picks one of the two 10-bit codes around the exact PQ value of `nits` so
+// that the bar averages to `nits` in luminance (PatternDitherCodes()).
+float DitherPQ(float nits, int2 screenPos)
+{
+    float v  = ApplyPQ((nits / 10000.0).xxx).x * 1023.0;
+    float lo = min(floor(v), 1022.0);
+    float hi = lo + 1.0;
+
+    float loNits = RemovePQ(lo / 1023.0) * 10000.0;
+    float hiNits = RemovePQ(hi / 1023.0) * 10000.0;
+    float upper  = saturate((nits - loNits) / (hiNits - loNits));
+
+    float t = blueNoise.Load(int3(screenPos & BLUE_NOISE_MASK, 0)) + ditherPhase;
+    t = t - floor(t);
+    return ((t < upper) ? hi : lo) / 1023.0;
+}
+
 struct VsOut
 {
     float4 pos : SV_Position;
@@ -166,9 +219,9 @@ float4 main(VsOut input) : SV_Target
     float posInBar = fmod(screenCoord.y, barH);
     bool isSep = (posInBar < (float)SEP_PX) || (posInBar >= barH - (float)SEP_PX);
 
-    // Linearly interpolate luminance across bars
+    // Linearly interpolate luminance across bars, or look up the schedule
     float t = (numBars > 1) ? ((float)barIdx / (float)(numBars - 1)) : 0.0;
-    float barNits = lerp(startNits, endNits, t);
+    float barNits = (barTable != 0) ? barNitsTable[barIdx] : lerp(startNits, endNits, t);
 
     // Label rendering
     int cellH = 5 * FONT_SCALE;
@@ -182,8 +235,9 @@ float4 main(VsOut input) : SV_Target
 
     if (outputMode == 0)
     {
-        // HDR10 PQ direct: PQ-encode
-        barColor   = ApplyPQ((barNits / 10000.0).xxx);
+        // HDR10 PQ direct: PQ-encode, optionally dithered between codes
+        barColor   = (dither != 0) ? DitherPQ(barNits, (int2)screenCoord.xy).xxx
+                                   : ApplyPQ((barNits / 10000.0).xxx);
         labelColor = ApplyPQ((labelNits / 10000.0).xxx);
     }
     else
@@ -213,6 +267,7 @@ static const float DEFAULT_START_NITS = 0.005f;
 static const float DEFAULT_END_NITS   = 0.00248f;
 static const int   DEFAULT_NUM_BARS   = 20;
 static const float DEFAULT_LABEL_NITS = 5.0f;
+static const wchar_t* WINDOW_TITLE    = L"PQ Luminance Test Bars";
 
 enum OutputMode
 {
@@ -233,7 +288,10 @@ struct alignas(16) TestParamsCB
     int   numBars;
     int   outputMode;
     float labelNits;
-    float pad;
+    int   dither;
+    float ditherPhase;
+    int   barTable;
+    float pad[2];
 };
 
 // ---------------------------------------------------------------------------
@@ -247,6 +305,7 @@ static HWND                  g_hEditStart     = nullptr;
 static HWND                  g_hEditEnd       = nullptr;
 static HWND                  g_hEditBars      = nullptr;
 static HWND                  g_hComboMode     = nullptr;
+static HWND                  g_hComboSpacing  = nullptr;
 static HFONT                 g_hFont          = nullptr;
 
 static ID3D11Device*         g_device         = nullptr;
@@ -258,6 +317,9 @@ static ID3D11RenderTargetView* g_rtv          = nullptr;
 static ID3D11VertexShader*   g_vs             = nullptr;
 static ID3D11PixelShader*    g_ps             = nullptr;
 static ID3D11Buffer*         g_cbuffer        = nullptr;
+static ID3D11ShaderResourceView* g_blueNoiseSRV = nullptr;
+static ID3D11Buffer*         g_barNitsBuffer  = nullptr;
+static ID3D11ShaderResourceView* g_barNitsSRV = nullptr;
 static IDXGIFactory2*        g_factory        = nullptr;
 
 static float    g_startNits   = DEFAULT_START_NITS;
@@ -266,6 +328,30 @@ static int      g_numBars     = DEFAULT_NUM_BARS;
 static float    g_labelNits   = DEFAULT_LABEL_NITS;
 static OutputMode g_mode      = MODE_HDR10_PQ;
 
+// Blue-noise dithering of HDR10 bars (F8 cycles off / spatial / temporal)
+enum DitherMode
+{
+    DITHER_OFF      = 0,
+    DITHER_SPATIAL  = 1,
+    DITHER_TEMPORAL = 2
+};
+
+static DitherMode g_ditherMode  = DITHER_OFF;
+static uint64_t   g_ditherFrame = 0;
+static float      g_ditherPhase = 0.0f;    // phase of the frame being drawn
+
+// Bar spacing (toolbar). The schedule is rebuilt when the toolbar changes and
+// uploaded to the shader's bar table; empty = the shader's own lerp.
+static const int   MAX_TABLE_BARS = 100;    // toolbar bar limit
+static const char* LEVELS_FILE    = "levels.txt";
+
+static BarSpacing         g_spacing      = BAR_SPACING_LINEAR;
+static std::vector<float> g_barNits;
+static std::vector<float> g_barLevels;      // levels.txt, read when List is selected
+static bool               g_barNitsDirty = false;
+static std::string        g_spacingError;
+static bool               g_settingEdits = false;  // suppresses EN_CHANGE while List writes the edits
+
 static bool     g_fullscreen     = false;
 static RECT     g_savedWindowRect = {};
 static LONG     g_savedStyle      = 0;
@@ -273,6 +359,22 @@ static LONG     g_savedExStyle    = 0;
 
 static bool     g_needsResize    = false;
 static bool     g_initialized    = false;
+static bool     g_analyzeRequested = false;
+
+// Temporal sequence state (F9). Presents are tracked by DXGI present count so
+// frame statistics can be matched back to sequence frames.
+static const int SEQ_PRESENT_RING   = 16;
+static const int SEQ_DRAIN_PRESENTS = 8;    // presents to wait for the last frames' statistics
+
+static FrameSequencer g_sequencer;
+static bool     g_seqRunning       = false;
+static int      g_seqDrain         = 0;     // > 0 once the last frame has been submitted
+static int      g_seqFrameForPresent[SEQ_PRESENT_RING];
+static UINT     g_seqLastReported  = 0;     // last present count fed to the sequencer
+static UINT     g_seqFinalPresent  = 0;     // present count of the latest sequence frame
+static double   g_seqRefreshHz     = 60.0;
+static LONGLONG g_seqQpcStart      = 0;
+static LONGLONG g_seqQpcFreq       = 1;
 
 // ---------------------------------------------------------------------------
 // Control IDs
@@ -286,6 +388,8 @@ static bool     g_initialized    = false;
 #define IDC_LABEL_END   106
 #define IDC_LABEL_BARS  107
 #define IDC_LABEL_MODE  108
+#define IDC_COMBO_SPACING 109
+#define IDC_LABEL_SPACING 110
 
 // ---------------------------------------------------------------------------
 // Forward declarations
@@ -298,6 +402,9 @@ static void Render();
 static void ToggleFullscreen();
 static void ParseControls();
 static void ResizeSwapChain();
+static void AnalyzeBackBuffer(const PatternParams& drawn);
+static void StartSequence();
+static void FinishSequence();
 static LRESULT CALLBACK WndProc(HWND, UINT, WPARAM, LPARAM);
 
 // ---------------------------------------------------------------------------
@@ -486,6 +593,45 @@ static bool InitD3D()
     hr = g_device->CreateBuffer(&cbd, nullptr, &g_cbuffer);
     if (FAILED(hr)) return false;
 
+    // Blue-noise dither mask: generated once on the CPU, immutable on the GPU
+    D3D11_TEXTURE2D_DESC nd = {};
+    nd.Width            = BLUE_NOISE_SIZE;
+    nd.Height           = BLUE_NOISE_SIZE;
+    nd.MipLevels        = 1;
+    nd.ArraySize        = 1;
+    nd.Format           = DXGI_FORMAT_R32_FLOAT;
+    nd.SampleDesc.Count = 1;
+    nd.Usage            = D3D11_USAGE_IMMUTABLE;
+    nd.BindFlags        = D3D11_BIND_SHADER_RESOURCE;
+
+    D3D11_SUBRESOURCE_DATA noiseData = {};
+    noiseData.pSysMem     = BlueNoiseMask();
+    noiseData.SysMemPitch = BLUE_NOISE_SIZE * sizeof(float);
+
+    ID3D11Texture2D* noiseTex = nullptr;
+    hr = g_device->CreateTexture2D(&nd, &noiseData, &noiseTex);
+    if (FAILED(hr)) return false;
+    hr = g_device->CreateShaderResourceView(noiseTex, nullptr, &g_blueNoiseSRV);
+    noiseTex->Release();
+    if (FAILED(hr)) return false;
+
+    // Bar luminance table for spacing schedules, rewritten on parameter change
+    D3D11_BUFFER_DESC td = {};
+    td.ByteWidth      = MAX_TABLE_BARS * sizeof(float);
+    td.Usage          = D3D11_USAGE_DYNAMIC;
+    td.BindFlags      = D3D11_BIND_SHADER_RESOURCE;
+    td.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    hr = g_device->CreateBuffer(&td, nullptr, &g_barNitsBuffer);
+    if (FAILED(hr)) return false;
+
+    D3D11_SHADER_RESOURCE_VIEW_DESC tv = {};
+    tv.Format              = DXGI_FORMAT_R32_FLOAT;
+    tv.ViewDimension       = D3D11_SRV_DIMENSION_BUFFER;
+    tv.Buffer.FirstElement = 0;
+    tv.Buffer.NumElements  = MAX_TABLE_BARS;
+    hr = g_device->CreateShaderResourceView(g_barNitsBuffer, &tv, &g_barNitsSRV);
+    if (FAILED(hr)) return false;
+
     // Create swap chain for initial mode
     if (!CreateSwapChainForMode(g_mode)) return false;
 
@@ -521,6 +667,127 @@ static void ResizeSwapChain()
     CreateRTV();
 }
 
+// ---------------------------------------------------------------------------
+// Sequence pacing
+// ---------------------------------------------------------------------------
+
+static double QpcSeconds(LONGLONG qpc)
+{
+    return (double)(qpc - g_seqQpcStart) / (double)g_seqQpcFreq;
+}
+
+// Vblank the next Present(1, 0) can reach. Uses DXGI frame statistics when
+// the swap chain provides them, otherwise the QPC clock and refresh rate.
+static int64_t PredictNextVblank()
+{
+    DXGI_FRAME_STATISTICS st;
+    UINT submitted = 0;
+    if (SUCCEEDED(g_swapChain->GetFrameStatistics(&st)) && SUCCEEDED(g_swapChain->GetLastPresentCount(&submitted)))
+        return (int64_t)st.PresentRefreshCount + (int64_t)(submitted - st.PresentCount) + 1;
+
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return (int64_t)(QpcSeconds(now.QuadPart) * g_seqRefreshHz) + 1;
+}
+
+// Records the present just issued for sequence frame `frame` (-1 = not a
+// sequence frame) and reports every present that has reached the screen
+// since the last call.
+static void TrackSequencePresent(int frame)
+{
+    UINT presentCount = 0;
+    if (FAILED(g_swapChain->GetLastPresentCount(&presentCount))) return;
+    g_seqFrameForPresent[presentCount % SEQ_PRESENT_RING] = frame;
+    if (frame >= 0) g_seqFinalPresent = presentCount;
+
+    DXGI_FRAME_STATISTICS st;
+    if (FAILED(g_swapChain->GetFrameStatistics(&st)))
+    {
+        // No statistics (e.g. composed windowed swap chain): assume the
+        // present landed on the vblank after it returned
+        LARGE_INTEGER now;
+        QueryPerformanceCounter(&now);
+        double t = QpcSeconds(now.QuadPart);
+        g_sequencer.Displayed(frame, (int64_t)(t * g_seqRefreshHz) + 1, t);
+        g_seqLastReported = presentCount;
+        return;
+    }
+
+    if (g_seqLastReported == 0 || st.PresentCount - g_seqLastReported > (UINT)SEQ_PRESENT_RING)
+        g_seqLastReported = st.PresentCount - 1;
+
+    // Statistics describe the latest displayed present exactly; earlier ones
+    // not seen yet are assumed to have flipped on consecutive vblanks.
+    double period = 1.0 / g_seqRefreshHz;
+    double syncTime = QpcSeconds(st.SyncQPCTime.QuadPart);
+    for (UINT id = g_seqLastReported + 1; id - 1 != st.PresentCount; id++)
+    {
+        int64_t vblank = (int64_t)st.PresentRefreshCount - (int64_t)(st.PresentCount - id);
+        double  time   = syncTime - (double)((int64_t)st.SyncRefreshCount - vblank) * period;
+        g_sequencer.Displayed(g_seqFrameForPresent[id % SEQ_PRESENT_RING], vblank, time);
+    }
+    g_seqLastReported = st.PresentCount;
+}
+
+// F9: runs the first sequence of sequences.txt (see PatternDesc.h) if the
+// file exists, else a one-frame black / toolbar-range flicker. Frames are
+// paced at the display refresh rate.
+static void StartSequence()
+{
+    std::vector<SequenceFrame> frames;
+    if (GetFileAttributesA("sequences.txt") != INVALID_FILE_ATTRIBUTES)
+    {
+        PatternLibrary lib;
+        std::string error;
+        if (!LoadPatternLibrary("sequences.txt", lib, &error)
+            || !BuildLibrarySequence(lib, 0, frames, &error))
+        {
+            MessageBoxA(g_hWnd, error.c_str(), "Sequence", MB_OK | MB_ICONERROR);
+            return;
+        }
+    }
+    else
+    {
+        PatternParams base = {};
+        base.numBars   = g_numBars;
+        base.labelNits = g_labelNits;
+        NitsRange toolbar = { g_startNits, g_endNits };
+        NitsRange black   = { 0.0f, 0.0f };
+        frames = BuildFlickerSequence(base, toolbar, black, 1, 120);
+    }
+
+    DEVMODEW dm = {};
+    dm.dmSize = sizeof(dm);
+    g_seqRefreshHz = (EnumDisplaySettingsW(nullptr, ENUM_CURRENT_SETTINGS, &dm) && dm.dmDisplayFrequency > 1)
+        ? (double)dm.dmDisplayFrequency : 60.0;
+
+    LARGE_INTEGER freq, now;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    g_seqQpcFreq      = freq.QuadPart;
+    g_seqQpcStart     = now.QuadPart;
+    g_seqLastReported = 0;
+    for (int i = 0; i < SEQ_PRESENT_RING; i++) g_seqFrameForPresent[i] = -1;
+
+    PacingConfig config = { g_seqRefreshHz, g_seqRefreshHz, PACING_HOLD_TIMELINE };
+    g_sequencer.Start(frames, config);
+    g_seqRunning = g_sequencer.Active();
+    g_seqDrain   = 0;
+}
+
+// Reports pacing and writes the per-frame log to pacing.csv
+static void FinishSequence()
+{
+    g_sequencer.Stop();
+    g_seqRunning = false;
+    g_seqDrain   = 0;
+
+    std::string report = FormatPacingStats(g_sequencer.Stats());
+    report += g_sequencer.WriteCsv("pacing.csv") ? "\nPer-frame log: pacing.csv\n" : "\nCould not write pacing.csv\n";
+
+    MessageBoxA(g_hWnd, report.c_str(), "Sequence Pacing", MB_OK);
+}
+
 // ---------------------------------------------------------------------------
 // Render
 // ---------------------------------------------------------------------------
@@ -529,6 +796,53 @@ static void Render()
 {
     if (!g_context || !g_rtv) return;
 
+    // A running sequence overrides the toolbar range for this frame
+    int   seqFrame  = -1;
+    float startNits = g_startNits;
+    float endNits   = g_endNits;
+    int   numBars   = g_numBars;
+    if (g_seqRunning && g_seqDrain == 0)
+    {
+        seqFrame = g_sequencer.FrameForVblank(PredictNextVblank());
+        if (seqFrame >= 0)
+        {
+            const PatternParams& sp = g_sequencer.Frame(seqFrame).params;
+            startNits = sp.startNits;
+            endNits   = sp.endNits;
+            numBars   = sp.numBars;
+        }
+        else
+        {
+            g_seqDrain = SEQ_DRAIN_PRESENTS;
+        }
+    }
+
+    g_ditherPhase = (g_ditherMode == DITHER_TEMPORAL) ? BlueNoisePhase(g_ditherFrame++) : 0.0f;
+
+    // Upload the spacing schedule once per change; sequence frames use the lerp
+    if (g_barNitsDirty && !g_barNits.empty())
+    {
+        D3D11_MAPPED_SUBRESOURCE table;
+        if (SUCCEEDED(g_context->Map(g_barNitsBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &table)))
+        {
+            memcpy(table.pData, g_barNits.data(), g_barNits.size() * sizeof(float));
+            g_context->Unmap(g_barNitsBuffer, 0);
+            g_barNitsDirty = false;
+        }
+    }
+    bool barTable = (seqFrame < 0) && !g_barNits.empty() && !g_barNitsDirty;
+
+    // What this frame draws, for F12; the size comes from the back buffer
+    PatternParams drawn = {};
+    drawn.startNits   = startNits;
+    drawn.endNits     = endNits;
+    drawn.numBars     = numBars;
+    drawn.outputMode  = (int)g_mode;
+    drawn.labelNits   = g_labelNits;
+    drawn.dither      = (g_ditherMode != DITHER_OFF) ? 1 : 0;
+    drawn.ditherPhase = g_ditherPhase;
+    drawn.barNits     = barTable ? g_barNits.data() : nullptr;
+
     // Update constant buffer
     D3D11_MAPPED_SUBRESOURCE mapped;
     if (SUCCEEDED(g_context->Map(g_cbuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped)))
@@ -539,14 +853,17 @@ static void Render()
         float vpH = max((float)(rc.bottom - rc.top), 1.0f);
 
         TestParamsCB cb;
-        cb.startNits  = g_startNits;
-        cb.endNits    = g_endNits;
-        cb.viewportW  = vpW;
-        cb.viewportH  = vpH;
-        cb.numBars    = g_numBars;
-        cb.outputMode = (int)g_mode;
-        cb.labelNits  = g_labelNits;
-        cb.pad        = 0.0f;
+        cb.startNits   = startNits;
+        cb.endNits     = endNits;
+        cb.viewportW   = vpW;
+        cb.viewportH   = vpH;
+        cb.numBars     = numBars;
+        cb.outputMode  = (int)g_mode;
+        cb.labelNits   = g_labelNits;
+        cb.dither      = (g_ditherMode != DITHER_OFF) ? 1 : 0;
+        cb.ditherPhase = g_ditherPhase;
+        cb.barTable    = barTable ? 1 : 0;
+        cb.pad[0] = cb.pad[1] = 0.0f;
 
         memcpy(mapped.pData, &cb, sizeof(cb));
         g_context->Unmap(g_cbuffer, 0);
@@ -571,10 +888,122 @@ static void Render()
     g_context->VSSetShader(g_vs, nullptr, 0);
     g_context->PSSetShader(g_ps, nullptr, 0);
     g_context->PSSetConstantBuffers(0, 1, &g_cbuffer);
+    ID3D11ShaderResourceView* srvs[2] = { g_blueNoiseSRV, g_barNitsSRV };
+    g_context->PSSetShaderResources(0, 2, srvs);
 
     g_context->Draw(3, 0);
 
+    if (g_analyzeRequested)
+    {
+        g_analyzeRequested = false;
+        AnalyzeBackBuffer(drawn);
+    }
+
     g_swapChain->Present(1, 0);
+
+    if (g_seqRunning)
+    {
+        TrackSequencePresent(seqFrame);
+        if (g_seqDrain > 0 && (--g_seqDrain == 0 || (int)(g_seqLastReported - g_seqFinalPresent) >= 0))
+            FinishSequence();
+    }
+}
+
+// ---------------------------------------------------------------------------
+// AnalyzeBackBuffer
+// ---------------------------------------------------------------------------
+
+// Reads back the frame just drawn, checks it carries exactly the codes the
+// pattern intends and diffs it against the CPU reference renderer (F12).
+// `drawn` holds the parameters the frame was rendered with, which differ
+// from the toolbar while a sequence plays.
+static void AnalyzeBackBuffer(const PatternParams& drawn)
+{
+    ID3D11Texture2D* backBuffer = nullptr;
+    HRESULT hr = g_swapChain->GetBuffer(0, __uuidof(ID3D11Texture2D), (void**)&backBuffer);
+    if (FAILED(hr)) return;
+
+    D3D11_TEXTURE2D_DESC desc;
+    backBuffer->GetDesc(&desc);
+    desc.Usage          = D3D11_USAGE_STAGING;
+    desc.BindFlags      = 0;
+    desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+    desc.MiscFlags      = 0;
+
+    ID3D11Texture2D* staging = nullptr;
+    hr = g_device->CreateTexture2D(&desc, nullptr, &staging);
+    if (FAILED(hr))
+    {
+        backBuffer->Release();
+        return;
+    }
+
+    g_context->CopyResource(staging, backBuffer);
+    backBuffer->Release();
+
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    hr = g_context->Map(staging, 0, D3D11_MAP_READ, 0, &mapped);
+    if (FAILED(hr))
+    {
+        staging->Release();
+        return;
+    }
+
+    PatternParams params = drawn;
+    params.width  = (int)desc.Width;
+    params.height = (int)desc.Height;
+
+    FrameView view;
+    view.data     = mapped.pData;
+    view.width    = (int)desc.Width;
+    view.height   = (int)desc.Height;
+    view.rowPitch = mapped.RowPitch;
+    view.format   = (g_mode == MODE_HDR10_PQ) ? FRAME_R10G10B10A2 : FRAME_RGBA16F;
+
+    CodeAnalysis analysis;
+    bool ok = AnalyzeFrameCodes(view, params, analysis);
+
+    // Any drift between the shader and PatternCore shows up here. A one-off
+    // readback, so the reference frame only lives for this call.
+    size_t refPitch = (size_t)view.width * FrameBytesPerPixel(view.format);
+    std::vector<uint8_t> reference(refPitch * (size_t)view.height);
+    RenderPatternFrame(params, reference.data(), refPitch);
+
+    FrameView refView = { reference.data(), view.width, view.height, refPitch, view.format };
+    FrameDiffOptions diffOptions = { 0, false, 0 };
+    FrameDiff diff;
+    bool diffOk = DiffFrames(refView, view, diffOptions, diff);
+
+    g_context->Unmap(staging, 0);
+    staging->Release();
+
+    if (!ok) return;
+
+    std::string report = FormatCodeAnalysis(analysis);
+    if (diffOk)
+    {
+        char line[160];
+        sprintf_s(line, "\nGPU vs CPU reference: %llu pixels differ, max delta %d",
+            (unsigned long long)diff.differing, diff.maxDelta);
+        report += line;
+        if (diff.firstY >= 0)
+        {
+            sprintf_s(line, ", first at (%d, %d)", diff.firstX, diff.firstY);
+            report += line;
+        }
+        report += "\n";
+    }
+
+    // Labels and codes the float math gets wrong against the reference
+    // (the lerp path only; schedules are computed in double)
+    PrecisionReport precision;
+    if (!params.barNits && CheckPatternPrecision(params, precision, 8)
+        && (precision.labelMismatches || precision.codeMismatches))
+    {
+        report += "\nFloat path vs high-precision reference:\n";
+        report += FormatPrecisionReport(precision, 8);
+    }
+    MessageBoxA(g_hWnd, report.c_str(), "Code Histogram", MB_OK);
 }
 
 // ---------------------------------------------------------------------------
@@ -638,6 +1067,93 @@ static void ToggleFullscreen()
 // ParseControls
 // ---------------------------------------------------------------------------
 
+// Shows the list's range and bar count in the toolbar and locks the edits
+// while List is in effect, so the toolbar never shows values not drawn.
+static void ShowListInEdits(bool list)
+{
+    if (list)
+    {
+        wchar_t buf[64];
+        g_settingEdits = true;
+        swprintf_s(buf, L"%.5f", g_startNits);
+        SetWindowTextW(g_hEditStart, buf);
+        swprintf_s(buf, L"%.5f", g_endNits);
+        SetWindowTextW(g_hEditEnd, buf);
+        swprintf_s(buf, L"%d", g_numBars);
+        SetWindowTextW(g_hEditBars, buf);
+        g_settingEdits = false;
+    }
+    EnableWindow(g_hEditStart, !list);
+    EnableWindow(g_hEditEnd,   !list);
+    EnableWindow(g_hEditBars,  !list);
+}
+
+// Reads levels.txt into g_barLevels. Only done when List is selected, so
+// editing the file takes effect on the next selection.
+static bool LoadLevelsFile()
+{
+    g_spacingError.clear();
+    if (!LoadBarLevels(LEVELS_FILE, g_barLevels, &g_spacingError)) return false;
+    if ((int)g_barLevels.size() > MAX_TABLE_BARS)
+    {
+        g_spacingError = std::string(LEVELS_FILE) + ": more than 100 levels";
+        g_barLevels.clear();
+        return false;
+    }
+    return true;
+}
+
+// Puts the spacing error in the window title while the bars are falling back
+// to the lerp, since most edits that cause it come from typing in the toolbar.
+static void ShowSpacingError()
+{
+    if (g_spacingError.empty())
+    {
+        SetWindowTextW(g_hWnd, WINDOW_TITLE);
+        return;
+    }
+    wchar_t title[256];
+    swprintf_s(title, L"%s - %S, drawing linear bars", WINDOW_TITLE, g_spacingError.c_str());
+    SetWindowTextW(g_hWnd, title);
+}
+
+// Rebuilds the bar luminance table for the toolbar spacing. List uses the
+// levels read by LoadLevelsFile and sets the bar count. On failure the bars
+// fall back to the lerp and g_spacingError says why.
+static void UpdateBarSchedule()
+{
+    int sel = (int)SendMessageW(g_hComboSpacing, CB_GETCURSEL, 0, 0);
+    g_spacing = (sel > 0 && sel <= BAR_SPACING_LIST) ? (BarSpacing)sel : BAR_SPACING_LINEAR;
+    g_spacingError.clear();
+    g_barNits.clear();
+    ShowListInEdits(false);
+    if (g_spacing == BAR_SPACING_LINEAR) return;
+
+    if (g_spacing == BAR_SPACING_LIST)
+    {
+        if (g_barLevels.empty())
+        {
+            g_spacingError = std::string(LEVELS_FILE) + " not loaded";
+            return;
+        }
+        g_numBars   = (int)g_barLevels.size();
+        g_startNits = g_barLevels.front();
+        g_endNits   = g_barLevels.back();
+        ShowListInEdits(true);
+    }
+
+    PatternParams p = {};
+    p.startNits = g_startNits;
+    p.endNits   = g_endNits;
+    p.numBars   = g_numBars;
+    if (!BuildBarSchedule(g_spacing, p, g_barLevels, g_barNits, &g_spacingError))
+    {
+        g_barNits.clear();
+        return;
+    }
+    g_barNitsDirty = true;
+}
+
 static void ParseControls()
 {
     wchar_t buf[64];
@@ -661,6 +1177,9 @@ static void ParseControls()
     {
         CreateSwapChainForMode(newMode);
     }
+
+    UpdateBarSchedule();
+    ShowSpacingError();
 }
 
 // ---------------------------------------------------------------------------
@@ -701,7 +1220,7 @@ static LRESULT CALLBACK WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lPara
         return 0;
 
     case WM_COMMAND:
-        if (g_initialized)
+        if (g_initialized && !g_settingEdits)
         {
             int id   = LOWORD(wParam);
             int code = HIWORD(wParam);
@@ -715,6 +1234,24 @@ static LRESULT CALLBACK WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lPara
             {
                 ParseControls();
             }
+            if (id == IDC_COMBO_SPACING && code == CBN_SELCHANGE)
+            {
+                // A list that cannot be read leaves the toolbar on Linear
+                int sel = (int)SendMessageW(g_hComboSpacing, CB_GETCURSEL, 0, 0);
+                if (sel == BAR_SPACING_LIST && !LoadLevelsFile())
+                {
+                    std::string error = g_spacingError;
+                    SendMessageW(g_hComboSpacing, CB_SETCURSEL, BAR_SPACING_LINEAR, 0);
+                    ParseControls();
+                    MessageBoxA(g_hWnd, error.c_str(), "Bar Spacing", MB_OK | MB_ICONERROR);
+                }
+                else
+                {
+                    ParseControls();
+                    if (!g_spacingError.empty())
+                        MessageBoxA(g_hWnd, g_spacingError.c_str(), "Bar Spacing", MB_OK | MB_ICONERROR);
+                }
+            }
         }
         return 0;
 
@@ -723,6 +1260,20 @@ static LRESULT CALLBACK WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lPara
         {
             ToggleFullscreen();
         }
+        else if (wParam == VK_F12)
+        {
+            g_analyzeRequested = true;
+        }
+        else if (wParam == VK_F8)
+        {
+            g_ditherMode  = (DitherMode)((g_ditherMode + 1) % 3);
+            g_ditherFrame = 0;
+        }
+        else if (wParam == VK_F9)
+        {
+            if (g_seqRunning) FinishSequence();
+            else              StartSequence();
+        }
         else if (wParam == VK_RETURN)
         {
             // If focus is on an edit control, parse and move focus away
@@ -814,6 +1365,20 @@ static void CreateToolbar(HWND hWnd, HINSTANCE hInst)
     SendMessageW(g_hComboMode, CB_ADDSTRING, 0, (LPARAM)L"HDR10 PQ");
     SendMessageW(g_hComboMode, CB_ADDSTRING, 0, (LPARAM)L"FP16 scRGB");
     SendMessageW(g_hComboMode, CB_SETCURSEL, 0, 0);
+    x += 140 + gap;
+
+    // Items in BarSpacing order
+    MakeLabel(L"Spacing:", IDC_LABEL_SPACING, 52);
+    g_hComboSpacing = CreateWindowExW(0, L"COMBOBOX", nullptr,
+        WS_CHILD | WS_VISIBLE | WS_TABSTOP | CBS_DROPDOWNLIST,
+        x, y - 2, 160, 200, hWnd, (HMENU)(INT_PTR)IDC_COMBO_SPACING, hInst, nullptr);
+    SendMessageW(g_hComboSpacing, WM_SETFONT, (WPARAM)g_hFont, TRUE);
+    SendMessageW(g_hComboSpacing, CB_ADDSTRING, 0, (LPARAM)L"Linear (nits)");
+    SendMessageW(g_hComboSpacing, CB_ADDSTRING, 0, (LPARAM)L"PQ uniform");
+    SendMessageW(g_hComboSpacing, CB_ADDSTRING, 0, (LPARAM)L"Logarithmic");
+    SendMessageW(g_hComboSpacing, CB_ADDSTRING, 0, (LPARAM)L"JND (Barten)");
+    SendMessageW(g_hComboSpacing, CB_ADDSTRING, 0, (LPARAM)L"List (levels.txt)");
+    SendMessageW(g_hComboSpacing, CB_SETCURSEL, 0, 0);
 }
 
 // ---------------------------------------------------------------------------
@@ -841,7 +1406,7 @@ int WINAPI wWinMain(HINSTANCE hInst, HINSTANCE, LPWSTR, int nCmdShow)
     AdjustWindowRectEx(&rc, WS_OVERLAPPEDWINDOW, FALSE, 0);
 
     g_hWnd = CreateWindowExW(0, L"PQLuminanceTestClass",
-        L"PQ Luminance Test Bars",
+        WINDOW_TITLE,
         WS_OVERLAPPEDWINDOW | WS_CLIPCHILDREN,
         CW_USEDEFAULT, CW_USEDEFAULT,
         rc.right - rc.left, rc.bottom - rc.top,
@@ -903,6 +1468,9 @@ int WINAPI wWinMain(HINSTANCE hInst, HINSTANCE, LPWSTR, int nCmdShow)
 
 done:
     // Cleanup
+    SafeRelease(g_barNitsSRV);
+    SafeRelease(g_barNitsBuffer);
+    SafeRelease(g_blueNoiseSRV);
     SafeRelease(g_cbuffer);
     SafeRelease(g_ps);
     SafeRelease(g_vs);
@@ -0,0 +1,46 @@
+#pragma once
+
+// ---------------------------------------------------------------------------
+// Minimal fork/join helpers for the CPU-side analysis tools.
+// ---------------------------------------------------------------------------
+
+#include <thread>
+#include <vector>
+
+// Number of workers to use for `items` units of work, never giving a worker
+// fewer than `minItemsPerWorker` units.
+inline int ParallelWorkerCount(int items, int minItemsPerWorker)
+{
+    int hw = (int)std::thread::hardware_concurrency();
+    if (hw < 1) hw = 1;
+    if (minItemsPerWorker < 1) minItemsPerWorker = 1;
+    int byWork = items / minItemsPerWorker;
+    if (byWork < 1) byWork = 1;
+    return (hw < byWork) ? hw : byWork;
+}
+
+// Splits [0, items) into `workers` contiguous bands and calls
+// fn(worker, begin, end) for each. Band 0 runs on the calling thread.
+template<typename Fn>
+inline void ParallelForBands(int items, int workers, Fn&& fn)
+{
+    if (workers < 1) workers = 1;
+    if (workers == 1 || items <= 1)
+    {
+        fn(0, 0, items);
+        return;
+    }
+
+    std::vector<std::thread> threads;
+    threads.reserve(workers - 1);
+    for (int w = 1; w < workers; w++)
+    {
+        int begin = (int)((long long)items * w / workers);
+        int end   = (int)((long long)items * (w + 1) / workers);
+        threads.emplace_back([&fn, w, begin, end]() { fn(w, begin, end); });
+    }
+
+    fn(0, 0, (int)((long long)items / workers));
+
+    for (auto& t : threads) t.join();
+}
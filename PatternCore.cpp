@@ -0,0 +1,337 @@
+#include "PatternCore.h"
+
+#include <cmath>
+#include <cstring>
+
+// ---------------------------------------------------------------------------
+// Layout
+// ---------------------------------------------------------------------------
+
+PatternLayout PatternDefaultLayout()
+{
+    PatternLayout l;
+    l.sepPx      = PATTERN_SEP_PX;
+    l.fontScale  = PATTERN_FONT_SCALE;
+    l.labelX     = PATTERN_LABEL_X;
+    l.labelChars = PATTERN_LABEL_CHARS;
+    l.labels     = true;
+    return l;
+}
+
+PatternRow PatternClassifyRow(const PatternParams& p, int y)
+{
+    return PatternClassifyRow(p, PatternDefaultLayout(), y);
+}
+
+PatternRow PatternClassifyRow(const PatternParams& p, const PatternLayout& layout, int y)
+{
+    // Same sequence of float operations as main() in g_psSource; SV_Position
+    // is sampled at the pixel centre.
+    float screenY  = (float)y + 0.5f;
+    float barH     = (float)p.height / (float)p.numBars;
+
+    int barIdx = (int)(screenY / barH);
+    if (barIdx < 0) barIdx = 0;
+    if (barIdx > p.numBars - 1) barIdx = p.numBars - 1;
+
+    float posInBar = fmodf(screenY, barH);
+
+    PatternRow row;
+    row.barIdx = barIdx;
+    row.isSep  = (posInBar < (float)layout.sepPx) || (posInBar >= barH - (float)layout.sepPx);
+    row.labelY = (int)(barIdx * barH + (barH - (float)PatternCellH(layout)) * 0.5f);
+    return row;
+}
+
+float PatternBarNits(const PatternParams& p, int barIdx)
+{
+    if (p.barNits) return p.barNits[barIdx];
+
+    // HLSL lerp(x, y, s) = x + s * (y - x)
+    float t = (p.numBars > 1) ? ((float)barIdx / (float)(p.numBars - 1)) : 0.0f;
+    return p.startNits + t * (p.endNits - p.startNits);
+}
+
+// ---------------------------------------------------------------------------
+// Label text
+// ---------------------------------------------------------------------------
+
+// 3x5 glyphs, same packing as kDigits in the shader
+static const uint32_t s_digits[10] = {
+    31599u, 11415u, 29671u, 29647u, 23497u,
+    31183u, 31215u, 29257u, 31727u, 31695u
+};
+
+static bool SampleGlyph(uint32_t digit, int fx, int fy)
+{
+    if ((uint32_t)fx >= 3u || (uint32_t)fy >= 5u) return false;
+    uint32_t bitIdx = (4u - (uint32_t)fy) * 3u + (2u - (uint32_t)fx);
+    return (s_digits[digit] >> bitIdx) & 1u;
+}
+
+static uint32_t ClampDigit(int d)
+{
+    return (uint32_t)(d < 0 ? 0 : (d > 9 ? 9 : d));
+}
+
+void PatternLabelParts(float nits, int& intPart, int& fracVal)
+{
+    // HLSL round() is round-half-to-even
+    intPart = (int)nits;
+    fracVal = (int)nearbyintf((nits - (float)intPart) * 100000.0f);
+}
+
+bool PatternSampleValue(float nits, int x, int y, int originX, int originY)
+{
+    return PatternSampleValue(nits, x, y, originX, originY, PATTERN_FONT_SCALE);
+}
+
+bool PatternSampleValue(float nits, int x, int y, int originX, int originY, int fontScale)
+{
+    const int cellW = (3 + 1) * fontScale;
+    const int cellH = 5 * fontScale;
+
+    int lx = x - originX;
+    int ly = y - originY;
+
+    if (ly < 0 || ly >= cellH || lx < 0) return false;
+
+    int intPart, fracVal;
+    PatternLabelParts(nits, intPart, fracVal);
+
+    int intDigits = 0;
+    {
+        int tmp = intPart > 0 ? intPart : 0;
+        if (tmp == 0) { intDigits = 1; }
+        else { while (tmp > 0) { intDigits++; tmp /= 10; } }
+    }
+
+    int totalChars = intDigits + 1 + 5;
+
+    int charIdx = lx / cellW;
+    if (charIdx >= totalChars) return false;
+
+    int fx = (lx % cellW) / fontScale;
+    int fy = ly / fontScale;
+    if (fx >= 3) return false;
+
+    if (charIdx < intDigits)
+    {
+        int divisor = 1;
+        for (int i = 0; i < (intDigits - 1 - charIdx); i++) divisor *= 10;
+        return SampleGlyph(ClampDigit((intPart / divisor) % 10), fx, fy);
+    }
+    else if (charIdx == intDigits)
+    {
+        return (fx == 1 && fy == 4);
+    }
+    else
+    {
+        int fracIdx = charIdx - intDigits - 1;
+        int divisor = 1;
+        for (int i = 0; i < (4 - fracIdx); i++) divisor *= 10;
+        return SampleGlyph(ClampDigit((fracVal / divisor) % 10), fx, fy);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Encoding
+// ---------------------------------------------------------------------------
+
+float PatternApplyPQ(float Y)
+{
+    const float m1 = 0.1593017578125f;
+    const float m2 = 78.84375f;
+    const float c1 = 0.8359375f;
+    const float c2 = 18.8515625f;
+    const float c3 = 18.6875f;
+
+    float Ym1 = powf(Y > 0.0f ? Y : 0.0f, m1);
+    float num = c1 + c2 * Ym1;
+    float den = 1.0f + c3 * Ym1;
+    return powf(num / den, m2);
+}
+
+float PatternRemovePQ(float V)
+{
+    const float m1 = 0.1593017578125f;
+    const float m2 = 78.84375f;
+    const float c1 = 0.8359375f;
+    const float c2 = 18.8515625f;
+    const float c3 = 18.6875f;
+
+    float Vm2 = powf(V > 0.0f ? V : 0.0f, 1.0f / m2);
+    float num = Vm2 - c1;
+    if (num < 0.0f) num = 0.0f;
+    return powf(num / (c2 - c3 * Vm2), 1.0f / m1);
+}
+
+double PatternPQEncode(double nits)
+{
+    const double m1 = 0.1593017578125;
+    const double m2 = 78.84375;
+    const double c1 = 0.8359375;
+    const double c2 = 18.8515625;
+    const double c3 = 18.6875;
+
+    double Ym1 = pow((nits > 0.0 ? nits : 0.0) / 10000.0, m1);
+    return pow((c1 + c2 * Ym1) / (1.0 + c3 * Ym1), m2);
+}
+
+double PatternPQDecode(double signal)
+{
+    const double m1 = 0.1593017578125;
+    const double m2 = 78.84375;
+    const double c1 = 0.8359375;
+    const double c2 = 18.8515625;
+    const double c3 = 18.6875;
+
+    double Vm2 = pow(signal > 0.0 ? signal : 0.0, 1.0 / m2);
+    double num = Vm2 - c1;
+    if (num < 0.0) num = 0.0;
+    return 10000.0 * pow(num / (c2 - c3 * Vm2), 1.0 / m1);
+}
+
+uint32_t PatternUnorm10(float v)
+{
+    if (!(v > 0.0f)) return 0;
+    if (v >= 1.0f)   return PQ_CODE_MAX;
+    return (uint32_t)(v * (float)PQ_CODE_MAX + 0.5f);
+}
+
+uint32_t PatternPQCode(float nits)
+{
+    return PatternUnorm10(PatternApplyPQ(nits / 10000.0f));
+}
+
+uint32_t PatternPackR10G10B10A2(float nits)
+{
+    return PatternPackCode10(PatternPQCode(nits));
+}
+
+uint32_t PatternPackCode10(uint32_t code)
+{
+    return code | (code << 10) | (code << 20) | (3u << 30);
+}
+
+uint64_t PatternPackRGBA16F(float nits)
+{
+    uint64_t h   = FloatToHalf(nits / 80.0f);
+    uint64_t one = FloatToHalf(1.0f);
+    return h | (h << 16) | (h << 32) | (one << 48);
+}
+
+uint64_t PatternPackTexel(FrameFormat format, float nits)
+{
+    return (format == FRAME_R10G10B10A2) ? (uint64_t)PatternPackR10G10B10A2(nits) : PatternPackRGBA16F(nits);
+}
+
+PatternDither PatternDitherCodes(float nits)
+{
+    PatternDither d;
+    float v  = PatternApplyPQ(nits / 10000.0f) * (float)PQ_CODE_MAX;
+    float lo = floorf(v);
+    if (lo > (float)(PQ_CODE_MAX - 1)) lo = (float)(PQ_CODE_MAX - 1);
+    float hi = lo + 1.0f;
+
+    float loNits = PatternRemovePQ(lo / (float)PQ_CODE_MAX) * 10000.0f;
+    float hiNits = PatternRemovePQ(hi / (float)PQ_CODE_MAX) * 10000.0f;
+    float upper  = (nits - loNits) / (hiNits - loNits);
+
+    d.lo    = (uint32_t)lo;
+    d.hi    = (uint32_t)hi;
+    d.upper = (upper > 0.0f) ? ((upper < 1.0f) ? upper : 1.0f) : 0.0f;
+    return d;
+}
+
+// ---------------------------------------------------------------------------
+// binary16
+// ---------------------------------------------------------------------------
+
+uint16_t FloatToHalf(float f)
+{
+    uint32_t x;
+    memcpy(&x, &f, sizeof(x));
+
+    uint32_t sign = (x >> 16) & 0x8000u;
+    uint32_t absX = x & 0x7FFFFFFFu;
+
+    if (absX >= 0x7F800000u)                       // Inf / NaN
+        return (uint16_t)(sign | 0x7C00u | (absX > 0x7F800000u ? 0x200u : 0u));
+    if (absX >= 0x477FF000u)                       // rounds above 65504
+        return (uint16_t)(sign | 0x7C00u);
+
+    if (absX < 0x38800000u)                        // result is subnormal or zero
+    {
+        if (absX < 0x33000000u) return (uint16_t)sign;
+        uint32_t mant  = (absX & 0x007FFFFFu) | 0x00800000u;
+        int      shift = 126 - (int)(absX >> 23);  // 14..24
+        uint32_t half  = mant >> shift;
+        uint32_t rem   = mant & ((1u << shift) - 1u);
+        uint32_t mid   = 1u << (shift - 1);
+        if (rem > mid || (rem == mid && (half & 1u))) half++;
+        return (uint16_t)(sign | half);
+    }
+
+    uint32_t half = ((absX >> 13) - (112u << 10));
+    uint32_t rem  = absX & 0x1FFFu;
+    if (rem > 0x1000u || (rem == 0x1000u && (half & 1u))) half++;
+    return (uint16_t)(sign | half);
+}
+
+float HalfToFloat(uint16_t h)
+{
+    uint32_t sign = (uint32_t)(h & 0x8000u) << 16;
+    uint32_t exp  = (h >> 10) & 0x1Fu;
+    uint32_t mant = h & 0x3FFu;
+    uint32_t x;
+
+    if (exp == 0)
+    {
+        if (mant == 0)
+        {
+            x = sign;
+        }
+        else
+        {
+            // Normalize subnormal
+            exp = 113;
+            while (!(mant & 0x400u)) { mant <<= 1; exp--; }
+            mant &= 0x3FFu;
+            x = sign | (exp << 23) | (mant << 13);
+        }
+    }
+    else if (exp == 31)
+    {
+        x = sign | 0x7F800000u | (mant << 13);
+    }
+    else
+    {
+        x = sign | ((exp + 112u) << 23) | (mant << 13);
+    }
+
+    float f;
+    memcpy(&f, &x, sizeof(f));
+    return f;
+}
+
+const uint16_t* HalfToPQCodeTable()
+{
+    struct Table
+    {
+        uint16_t codes[65536];
+        Table()
+        {
+            for (uint32_t i = 0; i < 65536; i++)
+            {
+                float v = HalfToFloat((uint16_t)i);
+                if (v != v)
+                    codes[i] = 0;           // NaN: compositors flush to black
+                else
+                    codes[i] = (uint16_t)PatternPQCode(v * 80.0f);
+            }
+        }
+    };
+    static const Table s_table;
+    return s_table.codes;
+}
@@ -0,0 +1,166 @@
+#pragma once
+
+// ---------------------------------------------------------------------------
+// PatternCore
+//
+// CPU-side mirror of the test-bar layout and encoding math used by the pixel
+// shader in Main.cpp. Everything here must stay bit-for-bit in step with the
+// HLSL (same float operations, same order) so that CPU tools can predict the
+// exact codes the GPU writes.
+//
+// This header is platform-neutral and is also pulled into Main.cpp after
+// <windows.h>, so it avoids std::min/std::max in inline code.
+// ---------------------------------------------------------------------------
+
+#include <cstdint>
+#include <cstddef>
+
+// ---------------------------------------------------------------------------
+// Layout constants (must match g_psSource)
+// ---------------------------------------------------------------------------
+
+static const int PATTERN_FONT_SCALE  = 4;
+static const int PATTERN_SEP_PX      = 2;
+static const int PATTERN_LABEL_X     = 10;
+static const int PATTERN_LABEL_CHARS = 12; // generous
+static const int PATTERN_CELL_W      = (3 + 1) * PATTERN_FONT_SCALE;
+static const int PATTERN_CELL_H      = 5 * PATTERN_FONT_SCALE;
+static const int PATTERN_LABEL_W     = PATTERN_LABEL_CHARS * PATTERN_CELL_W + 20;
+
+static const int PQ_CODE_MAX         = 1023;
+static const int PQ_CODE_BINS        = 1024;
+
+// Values match OutputMode in Main.cpp
+enum FrameFormat
+{
+    FRAME_R10G10B10A2 = 0,  // HDR10 PQ, 32 bits per pixel
+    FRAME_RGBA16F     = 1   // scRGB linear, 64 bits per pixel
+};
+
+// ---------------------------------------------------------------------------
+// Parameters describing one rendered frame (mirrors TestParamsCB)
+// ---------------------------------------------------------------------------
+
+struct PatternParams
+{
+    float startNits;
+    float endNits;
+    int   width;
+    int   height;
+    int   numBars;
+    int   outputMode;   // FrameFormat
+    float labelNits;
+    int   dither;       // 1 = blue-noise dither bars between PQ codes (HDR10 only)
+    float ditherPhase;  // temporal offset of the dither mask, [0, 1) (BlueNoisePhase)
+    const float* barNits;   // numBars luminances (BarSchedule.h), not owned; null = lerp
+};
+
+// Read-only view of a mapped or CPU-resident frame
+struct FrameView
+{
+    const void* data;
+    int         width;
+    int         height;
+    size_t      rowPitch;   // bytes
+    FrameFormat format;
+};
+
+// Geometry the shader hard-codes (SEP_PX, FONT_SCALE, label column). Pattern
+// descriptions may override it for CPU-rendered frames; the defaults are the
+// shader's values, so the plain overloads below stay in step with the GPU.
+struct PatternLayout
+{
+    int  sepPx;         // black rows at the top and bottom of each bar
+    int  fontScale;     // pixels per glyph dot
+    int  labelX;        // left margin of the label text
+    int  labelChars;    // width of the black label column, in glyph cells
+    bool labels;        // false = no label column and no text
+};
+
+// Per-scanline classification, as the shader computes it at pixel centres
+struct PatternRow
+{
+    int  barIdx;
+    bool isSep;
+    int  labelY;    // top row of this bar's label text
+};
+
+// ---------------------------------------------------------------------------
+// Layout / encoding
+// ---------------------------------------------------------------------------
+
+inline size_t FrameBytesPerPixel(FrameFormat format)
+{
+    return (format == FRAME_R10G10B10A2) ? 4 : 8;
+}
+
+PatternLayout PatternDefaultLayout();
+inline int    PatternCellW(const PatternLayout& l)  { return (3 + 1) * l.fontScale; }
+inline int    PatternCellH(const PatternLayout& l)  { return 5 * l.fontScale; }
+
+// Equals the shader's fixed labelW (12 * 16 + 20) at the default layout only
+inline int    PatternLabelW(const PatternLayout& l) { return l.labels ? l.labelChars * PatternCellW(l) + 2 * l.labelX : 0; }
+
+PatternRow PatternClassifyRow(const PatternParams& p, int y);
+PatternRow PatternClassifyRow(const PatternParams& p, const PatternLayout& layout, int y);
+
+// Bar luminance: the shader's lerp from startNits to endNits, or
+// p.barNits[barIdx] when a spacing schedule is set
+float      PatternBarNits(const PatternParams& p, int barIdx);
+
+// Integer part and 5-digit fraction the shader's label computes for `nits`
+// (float path, fracVal = round((nits - intPart) * 100000.0)). The fraction
+// can round up to 100000, of which the label only shows the low five digits.
+void       PatternLabelParts(float nits, int& intPart, int& fracVal);
+
+// SampleValue() from the shader: true if (x, y) lands on a lit pixel of the
+// "X.XXXXX" label for `nits` drawn at (originX, originY).
+bool       PatternSampleValue(float nits, int x, int y, int originX, int originY);
+bool       PatternSampleValue(float nits, int x, int y, int originX, int originY, int fontScale);
+
+// ST.2084 forward curve on normalized luminance (nits / 10000), float path
+float      PatternApplyPQ(float Y);
+
+// ST.2084 inverse on a [0,1] signal, float path; returns normalized luminance
+float      PatternRemovePQ(float V);
+
+// ST.2084 in double precision, both directions (nits <-> [0,1] signal). Not
+// the shader's float path: for reference values, ramps and format conversion.
+double     PatternPQEncode(double nits);
+double     PatternPQDecode(double signal);
+
+// Quantizes a [0,1] shader output to a 10-bit UNORM code
+uint32_t   PatternUnorm10(float v);
+
+// 10-bit PQ code the HDR10 path writes for a given luminance
+uint32_t   PatternPQCode(float nits);
+
+// Packed R10G10B10A2 (alpha = 3) / RGBA16F texel the shader writes for a grey level
+uint32_t   PatternPackR10G10B10A2(float nits);
+uint32_t   PatternPackCode10(uint32_t code);
+uint64_t   PatternPackRGBA16F(float nits);
+
+// Either of the above for `format`, widened to 64 bits; 0 nits is black
+uint64_t   PatternPackTexel(FrameFormat format, float nits);
+
+// Dithered bar: the 10-bit codes either side of the bar's exact PQ value and
+// the share of pixels that take the upper one, chosen so the bar's average
+// luminance (not its average code) matches. A pixel carries `hi` when its
+// blue-noise threshold is below `upper`. Same float operations as DitherPQ()
+// in the shader.
+struct PatternDither
+{
+    uint32_t lo;
+    uint32_t hi;
+    float    upper;
+};
+
+PatternDither PatternDitherCodes(float nits);
+
+// IEEE 754 binary16 conversion, round-to-nearest-even like the output merger
+uint16_t   FloatToHalf(float f);
+float      HalfToFloat(uint16_t h);
+
+// Maps every binary16 value (scRGB, 1.0 = 80 nits) to the 10-bit PQ code a
+// compositor would produce for it. 65536 entries, built once on first use.
+const uint16_t* HalfToPQCodeTable();
@@ -0,0 +1,464 @@
+#include "PatternDesc.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// ---------------------------------------------------------------------------
+// Tokenizer
+// ---------------------------------------------------------------------------
+
+namespace
+{
+
+const int MAX_TOKENS = 10;
+const int MAX_BARS   = 4096;
+const int MAX_SIZE   = 16384;
+
+struct Token
+{
+    const char* text;
+    size_t      len;
+
+    bool Is(const char* s) const
+    {
+        return strlen(s) == len && memcmp(text, s, len) == 0;
+    }
+
+    std::string Str() const { return std::string(text, len); }
+};
+
+// Splits [begin, end) on blanks; everything after '#' is ignored. Returns the
+// token count, or MAX_TOKENS + 1 if the line has too many.
+int SplitLine(const char* begin, const char* end, Token* tokens)
+{
+    int n = 0;
+    const char* c = begin;
+    while (c < end)
+    {
+        while (c < end && (*c == ' ' || *c == '\t' || *c == '\r')) c++;
+        if (c == end || *c == '#') break;
+
+        const char* start = c;
+        while (c < end && *c != ' ' && *c != '\t' && *c != '\r' && *c != '#') c++;
+        if (n == MAX_TOKENS) return MAX_TOKENS + 1;
+        tokens[n++] = Token{ start, (size_t)(c - start) };
+    }
+    return n;
+}
+
+bool ParseInt(const Token& t, int lo, int hi, int& out)
+{
+    char buf[32];
+    if (t.len == 0 || t.len >= sizeof(buf)) return false;
+    memcpy(buf, t.text, t.len);
+    buf[t.len] = '\0';
+
+    char* endp = nullptr;
+    errno = 0;
+    long v = strtol(buf, &endp, 10);
+    if (errno || *endp != '\0' || v < lo || v > hi) return false;
+    out = (int)v;
+    return true;
+}
+
+bool ParseNits(const Token& t, float& out)
+{
+    char buf[32];
+    if (t.len == 0 || t.len >= sizeof(buf)) return false;
+    memcpy(buf, t.text, t.len);
+    buf[t.len] = '\0';
+
+    char* endp = nullptr;
+    float v = strtof(buf, &endp);
+    if (*endp != '\0' || !(v >= 0.0f && v <= 10000.0f)) return false;
+    out = v;
+    return true;
+}
+
+bool ParseFraction(const Token& t, float& out)
+{
+    char buf[32];
+    if (t.len == 0 || t.len >= sizeof(buf)) return false;
+    memcpy(buf, t.text, t.len);
+    buf[t.len] = '\0';
+
+    char* endp = nullptr;
+    float v = strtof(buf, &endp);
+    if (*endp != '\0' || !(v >= 0.0f && v <= 1.0f)) return false;
+    out = v;
+    return true;
+}
+
+bool ParseRect(const Token* tok, LayoutShape& s)
+{
+    return ParseFraction(tok[0], s.x0) && ParseFraction(tok[1], s.y0)
+        && ParseFraction(tok[2], s.x1) && ParseFraction(tok[3], s.y1)
+        && s.x0 < s.x1 && s.y0 < s.y1;
+}
+
+bool ValidName(const Token& t)
+{
+    for (size_t i = 0; i < t.len; i++)
+    {
+        char c = t.text[i];
+        bool ok = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')
+            || c == '_' || c == '-' || c == '.';
+        if (!ok) return false;
+    }
+    return t.len > 0;
+}
+
+enum Block { BLOCK_NONE, BLOCK_PATTERN, BLOCK_SEQUENCE };
+
+// Sequence steps may name patterns defined further down the file, so they
+// are resolved after the whole library has been read.
+struct PendingStep
+{
+    int         sequence;
+    int         step;
+    std::string pattern;
+    int         line;
+};
+
+// Shape keywords; returns nullptr if tok[0] is not one, "" on success
+const char* ApplyShapeKeyword(const Token* tok, int n, PatternDesc& d)
+{
+    LayoutShape s = {};
+
+    if (tok[0].Is("background"))
+    {
+        if (n != 2 || !ParseNits(tok[1], d.backgroundNits)) return "background takes a luminance";
+        d.kind = PATTERN_SHAPES;
+        return "";
+    }
+    else if (tok[0].Is("rect"))
+    {
+        s.kind = SHAPE_RECT;
+        if (n != 6 || !ParseRect(tok + 1, s) || !ParseNits(tok[5], s.nits))
+            return "expected: rect x0 y0 x1 y1 nits";
+    }
+    else if (tok[0].Is("window"))
+    {
+        s.kind = SHAPE_WINDOW;
+        if (n != 3 || !ParseNits(tok[1], s.area) || s.area < 1.0f || s.area > 100.0f || !ParseNits(tok[2], s.nits))
+            return "expected: window <1-100 percent> nits";
+    }
+    else if (tok[0].Is("ramp"))
+    {
+        if (n != 8 || !ParseRect(tok + 1, s) || !ParseNits(tok[5], s.nits) || !ParseNits(tok[6], s.nits2)
+            || !(tok[7].Is("h") || tok[7].Is("v")))
+            return "expected: ramp x0 y0 x1 y1 from to h|v";
+        s.kind = tok[7].Is("h") ? SHAPE_RAMP_H : SHAPE_RAMP_V;
+    }
+    else if (tok[0].Is("checker"))
+    {
+        s.kind = SHAPE_CHECKER;
+        if (n != 9 || !ParseRect(tok + 1, s) || !ParseInt(tok[5], 1, MAX_SIZE, s.cols)
+            || !ParseInt(tok[6], 1, MAX_SIZE, s.rows) || !ParseNits(tok[7], s.nits) || !ParseNits(tok[8], s.nits2))
+            return "expected: checker x0 y0 x1 y1 cols rows a b";
+    }
+    else
+    {
+        return nullptr;
+    }
+
+    d.kind = PATTERN_SHAPES;
+    d.shapes.push_back(s);
+    return "";
+}
+
+// Applies one keyword line inside a pattern block; returns a reason on error.
+// `barKeyword` is set for keywords that only make sense for the bar layout.
+const char* ApplyPatternKeyword(const Token* tok, int n, PatternDesc& d, bool& barKeyword)
+{
+    PatternParams& p = d.params;
+    PatternLayout& l = d.layout;
+
+    const char* shape = ApplyShapeKeyword(tok, n, d);
+    if (shape) return *shape ? shape : nullptr;
+
+    barKeyword = !tok[0].Is("mode") && !tok[0].Is("size");
+
+    if (tok[0].Is("mode"))
+    {
+        if (n != 2) return "mode takes one value";
+        if      (tok[1].Is("pq"))    p.outputMode = FRAME_R10G10B10A2;
+        else if (tok[1].Is("scrgb")) p.outputMode = FRAME_RGBA16F;
+        else return "mode must be pq or scrgb";
+    }
+    else if (tok[0].Is("bars"))
+    {
+        if (n != 2 || !ParseInt(tok[1], 1, MAX_BARS, p.numBars)) return "bars must be 1-4096";
+    }
+    else if (tok[0].Is("range"))
+    {
+        if (n != 3 || !ParseNits(tok[1], p.startNits) || !ParseNits(tok[2], p.endNits))
+            return "range takes two luminances in 0-10000 nits";
+    }
+    else if (tok[0].Is("spacing"))
+    {
+        if (n != 2) return "spacing takes one value";
+        if      (tok[1].Is("linear")) d.spacing = BAR_SPACING_LINEAR;
+        else if (tok[1].Is("pq"))     d.spacing = BAR_SPACING_PQ;
+        else if (tok[1].Is("log"))    d.spacing = BAR_SPACING_LOG;
+        else if (tok[1].Is("jnd"))    d.spacing = BAR_SPACING_JND;
+        else return "spacing must be linear, pq, log or jnd";
+        d.levels.clear();
+    }
+    else if (tok[0].Is("levels"))
+    {
+        if (n < 2) return "levels takes one or more luminances";
+        for (int i = 1; i < n; i++)
+        {
+            float v;
+            if (!ParseNits(tok[i], v)) return "levels must be luminances in 0-10000 nits";
+            if ((int)d.levels.size() == MAX_BARS) return "more than 4096 levels";
+            d.levels.push_back(v);
+        }
+        d.spacing   = BAR_SPACING_LIST;
+        p.numBars   = (int)d.levels.size();
+        p.startNits = d.levels.front();
+        p.endNits   = d.levels.back();
+    }
+    else if (tok[0].Is("label"))
+    {
+        if (n == 2 && tok[1].Is("off")) l.labels = false;
+        else if (n == 2 && ParseNits(tok[1], p.labelNits)) l.labels = true;
+        else return "label takes a luminance or \"off\"";
+    }
+    else if (tok[0].Is("size"))
+    {
+        if (n != 3 || !ParseInt(tok[1], 1, MAX_SIZE, p.width) || !ParseInt(tok[2], 1, MAX_SIZE, p.height))
+            return "size takes width and height, 1-16384";
+    }
+    else if (tok[0].Is("separator"))
+    {
+        if (n != 2 || !ParseInt(tok[1], 0, 1024, l.sepPx)) return "separator must be 0-1024";
+    }
+    else if (tok[0].Is("font_scale"))
+    {
+        if (n != 2 || !ParseInt(tok[1], 1, 64, l.fontScale)) return "font_scale must be 1-64";
+    }
+    else if (tok[0].Is("label_chars"))
+    {
+        if (n != 2 || !ParseInt(tok[1], 0, 256, l.labelChars)) return "label_chars must be 0-256";
+    }
+    else if (tok[0].Is("label_x"))
+    {
+        if (n != 2 || !ParseInt(tok[1], 0, MAX_SIZE, l.labelX)) return "label_x must be 0-16384";
+    }
+    else
+    {
+        return "unknown keyword";
+    }
+    return nullptr;
+}
+
+// Checks the spacing against the final bar count and range (keywords may come
+// in any order)
+bool ValidSpacing(const PatternDesc& d, const char** reason)
+{
+    if (d.spacing == BAR_SPACING_LIST && d.params.numBars != (int)d.levels.size())
+    {
+        *reason = "bars does not match the number of levels";
+        return false;
+    }
+    if ((d.spacing == BAR_SPACING_LOG || d.spacing == BAR_SPACING_JND)
+        && !(d.params.startNits > 0.0f && d.params.endNits > 0.0f))
+    {
+        *reason = "log and jnd spacing need a range above 0 nits";
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// Library
+// ---------------------------------------------------------------------------
+
+int PatternLibrary::FindPattern(const std::string& name) const
+{
+    auto it = patternIndex.find(name);
+    return (it == patternIndex.end()) ? -1 : it->second;
+}
+
+int PatternLibrary::FindSequence(const std::string& name) const
+{
+    auto it = sequenceIndex.find(name);
+    return (it == sequenceIndex.end()) ? -1 : it->second;
+}
+
+PatternDesc DefaultPatternDesc(const std::string& name)
+{
+    // Toolbar start values in Main.cpp. Params are value-initialised so fields
+    // not set here (dither, ditherPhase, barNits) start at zero.
+    PatternDesc d;
+    d.params            = PatternParams();
+    d.name              = name;
+    d.kind              = PATTERN_BARS;
+    d.backgroundNits    = 0.0f;
+    d.params.startNits  = 0.005f;
+    d.params.endNits    = 0.00248f;
+    d.params.width      = 0;
+    d.params.height     = 0;
+    d.params.numBars    = 20;
+    d.params.outputMode = FRAME_R10G10B10A2;
+    d.params.labelNits  = 5.0f;
+    d.layout            = PatternDefaultLayout();
+    d.spacing           = BAR_SPACING_LINEAR;
+    return d;
+}
+
+bool ParsePatternLibrary(const char* text, size_t size, PatternLibrary& lib, std::string* error)
+{
+    lib = PatternLibrary();
+
+    std::vector<PendingStep> pending;
+    Block block  = BLOCK_NONE;
+    int   lineNo = 0;
+    bool  barKeywords = false;
+    const char* reason = nullptr;
+
+    const char* cur = text;
+    const char* end = text + size;
+    while (cur < end && !reason)
+    {
+        const char* eol = (const char*)memchr(cur, '\n', (size_t)(end - cur));
+        if (!eol) eol = end;
+        lineNo++;
+
+        Token tok[MAX_TOKENS];
+        int n = SplitLine(cur, eol, tok);
+        cur = eol + 1;
+
+        if (n == 0) continue;
+        if (n > MAX_TOKENS) { reason = "too many values"; break; }
+
+        if (block == BLOCK_NONE)
+        {
+            bool isPattern = tok[0].Is("pattern");
+            if (!isPattern && !tok[0].Is("sequence")) { reason = "expected pattern or sequence"; break; }
+            if (n != 2 || !ValidName(tok[1]))         { reason = "expected a name ([A-Za-z0-9_.-])"; break; }
+
+            std::string name = tok[1].Str();
+            if (isPattern)
+            {
+                if (!lib.patternIndex.emplace(name, (int)lib.patterns.size()).second)
+                {
+                    reason = "duplicate pattern name";
+                    break;
+                }
+                lib.patterns.push_back(DefaultPatternDesc(name));
+                block = BLOCK_PATTERN;
+                barKeywords = false;
+            }
+            else
+            {
+                if (!lib.sequenceIndex.emplace(name, (int)lib.sequences.size()).second)
+                {
+                    reason = "duplicate sequence name";
+                    break;
+                }
+                lib.sequences.push_back(PatternSequence{ name, {} });
+                block = BLOCK_SEQUENCE;
+            }
+            continue;
+        }
+
+        if (tok[0].Is("end"))
+        {
+            if (n != 1) { reason = "end takes no values"; break; }
+            if (block == BLOCK_SEQUENCE && lib.sequences.back().steps.empty())
+            {
+                reason = "sequence has no steps";
+                break;
+            }
+            if (block == BLOCK_PATTERN && barKeywords && lib.patterns.back().kind == PATTERN_SHAPES)
+            {
+                reason = "bar keywords cannot be mixed with shapes";
+                break;
+            }
+            if (block == BLOCK_PATTERN && !ValidSpacing(lib.patterns.back(), &reason)) break;
+            block = BLOCK_NONE;
+            continue;
+        }
+
+        if (block == BLOCK_PATTERN)
+        {
+            bool barKeyword = false;
+            reason = ApplyPatternKeyword(tok, n, lib.patterns.back(), barKeyword);
+            barKeywords |= barKeyword;
+        }
+        else
+        {
+            PatternStep step = { -1, 0 };
+            if (!tok[0].Is("step") || n != 3 || !ValidName(tok[1]) || !ParseInt(tok[2], 1, 1 << 24, step.frames))
+            {
+                reason = "expected: step <pattern> <frames>";
+                break;
+            }
+            PatternSequence& seq = lib.sequences.back();
+            pending.push_back(PendingStep{ (int)lib.sequences.size() - 1, (int)seq.steps.size(), tok[1].Str(), lineNo });
+            seq.steps.push_back(step);
+        }
+    }
+
+    if (!reason && block != BLOCK_NONE)
+    {
+        reason = "missing end";
+    }
+
+    if (!reason)
+    {
+        for (const PendingStep& s : pending)
+        {
+            int idx = lib.FindPattern(s.pattern);
+            if (idx < 0)
+            {
+                reason = "step names an unknown pattern";
+                lineNo = s.line;
+                break;
+            }
+            lib.sequences[s.sequence].steps[s.step].pattern = idx;
+        }
+    }
+
+    if (reason)
+    {
+        if (error)
+        {
+            char msg[128];
+            snprintf(msg, sizeof(msg), "line %d: %s", lineNo, reason);
+            *error = msg;
+        }
+        lib = PatternLibrary();
+        return false;
+    }
+    return true;
+}
+
+bool LoadPatternLibrary(const char* path, PatternLibrary& lib, std::string* error)
+{
+    FILE* f = fopen(path, "rb");
+    if (!f)
+    {
+        if (error) *error = std::string("cannot open ") + path;
+        return false;
+    }
+
+    // One read of the whole file; the parser never copies lines
+    std::vector<char> text;
+    char chunk[1 << 16];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0)
+        text.insert(text.end(), chunk, chunk + n);
+    fclose(f);
+
+    bool ok = ParsePatternLibrary(text.data(), text.size(), lib, error);
+    if (!ok && error) *error = std::string(path) + ":" + *error;
+    return ok;
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+// ---------------------------------------------------------------------------
+// PatternDesc
+//
+// Text format for pattern libraries: everything the toolbar and the layout
+// constants in Main.cpp control, plus named sequences of patterns. Parsed and
+// validated once; compile a pattern into a RenderPlan (RenderPlan.h) to draw
+// it. '#' starts a comment, keywords may appear in any order, omitted ones
+// keep the app defaults:
+//
+//   pattern near_black
+//       mode        pq              # pq | scrgb
+//       bars        20
+//       range       0.005 0.00248   # first and last bar, nits
+//       spacing     pq              # linear | pq | log | jnd (BarSchedule.h)
+//       levels      0.005 0.01 0.02 # explicit bar luminances, repeatable;
+//                                   # sets the bar count
+//       label       5               # label luminance in nits, or "off"
+//       size        3840 2160       # optional, otherwise the target size
+//       separator   2               # SEP_PX
+//       font_scale  4               # FONT_SCALE
+//       label_chars 12              # label column width in glyph cells
+//       label_x     10              # label text margin
+//   end
+//
+// The layout keywords (separator, font_scale, label_chars, label_x) are
+// export-only: they shape CPU renders, render plans and span frames, but the
+// app's shader hard-codes the defaults, so a pattern that overrides them
+// never matches what the app draws. Sequences reject them
+// (BuildLibrarySequence).
+//
+// A pattern that uses any of the shape keywords below is a shape layout
+// instead of bars: shapes are painted over the background in file order.
+// Coordinates are fractions of the frame, luminances are nits.
+//
+//   pattern window_10
+//       background  0
+//       window      10 1000         # centred, percent of frame area
+//       rect        0 0 0.1 0.1 100 # x0 y0 x1 y1 nits
+//       ramp        0 0.9 1 1 0 100 h   # x0 y0 x1 y1 from to h|v, PQ-uniform
+//       checker     0.2 0.2 0.8 0.8 8 6 0 100   # x0 y0 x1 y1 cols rows a b
+//   end
+//
+//   sequence flicker
+//       step near_black 30          # pattern name, frame count
+//       step white_step 30
+//   end
+// ---------------------------------------------------------------------------
+
+#include "BarSchedule.h"
+#include "PatternCore.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum PatternKind
+{
+    PATTERN_BARS   = 0,     // the shader's bar layout
+    PATTERN_SHAPES = 1      // background plus LayoutShapes
+};
+
+enum ShapeKind
+{
+    SHAPE_RECT    = 0,
+    SHAPE_WINDOW  = 1,
+    SHAPE_RAMP_H  = 2,
+    SHAPE_RAMP_V  = 3,
+    SHAPE_CHECKER = 4
+};
+
+struct LayoutShape
+{
+    ShapeKind kind;
+    float     x0, y0, x1, y1;   // fractions of the frame (unused by windows)
+    float     area;             // window: percent of the frame, 1-100
+    float     nits;             // fill, ramp start, first checker cell
+    float     nits2;            // ramp end, second checker cell
+    int       cols, rows;       // checker cells
+};
+
+struct PatternDesc
+{
+    std::string              name;
+    PatternKind              kind;
+    PatternParams            params;    // width/height 0 = use the render target size
+    PatternLayout            layout;    // bars only
+    BarSpacing               spacing;   // bars only
+    std::vector<float>       levels;    // BAR_SPACING_LIST luminances
+    float                    backgroundNits;
+    std::vector<LayoutShape> shapes;
+};
+
+struct PatternStep
+{
+    int pattern;            // index into PatternLibrary::patterns
+    int frames;
+};
+
+struct PatternSequence
+{
+    std::string              name;
+    std::vector<PatternStep> steps;
+};
+
+struct PatternLibrary
+{
+    std::vector<PatternDesc>     patterns;
+    std::vector<PatternSequence> sequences;
+
+    // -1 if not found
+    int FindPattern(const std::string& name) const;
+    int FindSequence(const std::string& name) const;
+
+    std::unordered_map<std::string, int> patternIndex;
+    std::unordered_map<std::string, int> sequenceIndex;
+};
+
+// App defaults (toolbar start values, shader layout), no size
+PatternDesc DefaultPatternDesc(const std::string& name);
+
+// `text` need not be NUL-terminated. On failure `lib` is left empty and
+// `error` holds "line N: reason".
+bool ParsePatternLibrary(const char* text, size_t size, PatternLibrary& lib, std::string* error);
+bool LoadPatternLibrary(const char* path, PatternLibrary& lib, std::string* error);
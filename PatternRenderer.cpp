@@ -0,0 +1,133 @@
+#include "PatternRenderer.h"
+#include "BlueNoise.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <cstring>
+
+// ---------------------------------------------------------------------------
+// Texel helpers
+// ---------------------------------------------------------------------------
+
+namespace
+{
+
+struct Texels32
+{
+    typedef uint32_t Type;
+    static Type Black()            { return 3u << 30; }
+    static Type Grey(float nits)   { return PatternPackR10G10B10A2(nits); }
+    static Type Code(uint32_t c)   { return PatternPackCode10(c); }
+};
+
+struct Texels64
+{
+    typedef uint64_t Type;
+    static Type Black()            { return (uint64_t)FloatToHalf(1.0f) << 48; }
+    static Type Grey(float nits)   { return PatternPackRGBA16F(nits); }
+    static Type Code(uint32_t)     { return Black(); }  // scRGB is never dithered
+};
+
+// Fills [x0, x1) of a bar scanline from the blue-noise tile: one threshold
+// compare per tile column, then the row repeats the tile.
+template<typename Texel>
+void FillDithered(Texel* row, int x0, int x1, const float* noise, float phase,
+    Texel lo, Texel hi, float upper)
+{
+    Texel tile[BLUE_NOISE_SIZE];
+    for (int i = 0; i < BLUE_NOISE_SIZE; i++)
+        tile[i] = (BlueNoiseThreshold(noise[i], phase) < upper) ? hi : lo;
+
+    int x = x0;
+    for (; x < x1 && (x & BLUE_NOISE_MASK) != 0; x++) row[x] = tile[x & BLUE_NOISE_MASK];
+    for (; x + BLUE_NOISE_SIZE <= x1; x += BLUE_NOISE_SIZE) memcpy(row + x, tile, sizeof(tile));
+    for (; x < x1; x++) row[x] = tile[x & BLUE_NOISE_MASK];
+}
+
+template<typename T>
+void RenderRows(const PatternParams& p, uint8_t* dst, size_t rowPitch, int y0, int y1)
+{
+    typedef typename T::Type Texel;
+
+    const Texel black = T::Black();
+    const Texel label = T::Grey(p.labelNits);
+    const int   labelW = (p.width < PATTERN_LABEL_W) ? p.width : PATTERN_LABEL_W;
+
+    // Widest label: 10 integer digits + '.' + 5 fractional
+    const int textEnd = (std::min)(p.width, PATTERN_LABEL_X + 16 * PATTERN_CELL_W);
+
+    const bool   dither = p.dither && p.outputMode == FRAME_R10G10B10A2;
+    const float* mask   = dither ? BlueNoiseMask() : nullptr;
+
+    int   cachedBar = -1;
+    Texel barTexel  = black;
+    float barNits   = 0.0f;
+    PatternDither barDither = {};
+
+    for (int y = y0; y < y1; y++)
+    {
+        Texel* row = (Texel*)(dst + (size_t)(y - y0) * rowPitch);
+        PatternRow info = PatternClassifyRow(p, y);
+
+        if (info.isSep)
+        {
+            std::fill(row, row + p.width, black);
+            continue;
+        }
+
+        if (info.barIdx != cachedBar)
+        {
+            cachedBar = info.barIdx;
+            barNits   = PatternBarNits(p, cachedBar);
+            barTexel  = T::Grey(barNits);
+            if (dither) barDither = PatternDitherCodes(barNits);
+        }
+
+        std::fill(row, row + labelW, black);
+        if (dither)
+            FillDithered(row, labelW, p.width, mask + (size_t)(y & BLUE_NOISE_MASK) * BLUE_NOISE_SIZE,
+                p.ditherPhase, T::Code(barDither.lo), T::Code(barDither.hi), barDither.upper);
+        else
+            std::fill(row + labelW, row + p.width, barTexel);
+
+        int ly = y - info.labelY;
+        if (ly < 0 || ly >= PATTERN_CELL_H) continue;
+
+        for (int x = PATTERN_LABEL_X; x < textEnd; x++)
+        {
+            if (PatternSampleValue(barNits, x, y, PATTERN_LABEL_X, info.labelY))
+                row[x] = label;
+        }
+    }
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+size_t PatternFrameBytes(const PatternParams& p)
+{
+    return (size_t)p.width * (size_t)p.height * FrameBytesPerPixel((FrameFormat)p.outputMode);
+}
+
+void RenderPatternRows(const PatternParams& p, void* dst, size_t rowPitch, int y0, int y1)
+{
+    if (p.numBars < 1 || p.width <= 0) return;
+
+    if (p.outputMode == FRAME_R10G10B10A2)
+        RenderRows<Texels32>(p, (uint8_t*)dst, rowPitch, y0, y1);
+    else
+        RenderRows<Texels64>(p, (uint8_t*)dst, rowPitch, y0, y1);
+}
+
+void RenderPatternFrame(const PatternParams& p, void* dst, size_t rowPitch, int workers)
+{
+    if (workers <= 0) workers = ParallelWorkerCount(p.height, 128);
+
+    ParallelForBands(p.height, workers, [&](int, int y0, int y1)
+    {
+        RenderPatternRows(p, (uint8_t*)dst + (size_t)y0 * rowPitch, rowPitch, y0, y1);
+    });
+}
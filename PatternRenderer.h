@@ -0,0 +1,23 @@
+#pragma once
+
+// ---------------------------------------------------------------------------
+// PatternRenderer
+//
+// CPU reference renderer for the test pattern. Produces the same texels the
+// pixel shader writes (separator > text > label bg > bar), one scanline at a
+// time: constant runs are filled directly and only the label band is sampled
+// per pixel. Dithered HDR10 bars repeat a per-scanline blue-noise tile.
+// ---------------------------------------------------------------------------
+
+#include "PatternCore.h"
+
+// Bytes needed for a tightly packed frame described by `p`
+size_t PatternFrameBytes(const PatternParams& p);
+
+// Renders into `dst` (rowPitch bytes per scanline). `workers` <= 0 picks a
+// thread count automatically; 1 renders on the calling thread.
+void RenderPatternFrame(const PatternParams& p, void* dst, size_t rowPitch, int workers = 0);
+
+// Renders scanlines [y0, y1) only; `dst` points at scanline y0. Lets callers
+// stream a frame through a small band buffer.
+void RenderPatternRows(const PatternParams& p, void* dst, size_t rowPitch, int y0, int y1);
@@ -0,0 +1,248 @@
+#include "PrecisionCheck.h"
+#include "FrameCompare.h"
+#include "Parallel.h"
+
+#include <cmath>
+#include <cstdio>
+
+// ---------------------------------------------------------------------------
+// Per-bar evaluation
+// ---------------------------------------------------------------------------
+
+namespace
+{
+
+struct ScanState
+{
+    uint64_t                   configs;
+    uint64_t                   bars;
+    uint64_t                   labelMismatches;
+    uint64_t                   codeMismatches;
+    int                        maxCodeError;
+    double                     maxRelNitsError;
+    std::vector<PrecisionCase> cases;
+};
+
+// The float path's PQ value is within ~1e-5 of the reference (a hundredth of
+// a code), so the double-precision curve is only evaluated when the float
+// value lies this close to a rounding boundary; everywhere else both paths
+// round to the same code. Keeps the scan at float cost for ~90% of bars.
+const double REFERENCE_MARGIN = 0.125;     // in codes
+
+uint32_t ReferenceCode(double nits)
+{
+    double v = PatternPQEncode(nits) * (double)PQ_CODE_MAX;
+    if (!(v > 0.0))               return 0;
+    if (v >= (double)PQ_CODE_MAX) return PQ_CODE_MAX;
+    return (uint32_t)(v + 0.5);
+}
+
+// Evaluates every bar of one configuration, adding the number of bars with a
+// label / code mismatch to `labelBars` / `codeBars`.
+void EvaluateConfig(double start, double end, int numBars, size_t maxCases, ScanState& st,
+    uint32_t& labelBars, uint32_t& codeBars)
+{
+    PatternParams p = {};
+    p.startNits = (float)start;
+    p.endNits   = (float)end;
+    p.numBars   = numBars;
+
+    const long double startL = start;
+    const long double rangeL = (long double)end - startL;
+
+    st.configs++;
+    st.bars += (uint64_t)numBars;
+
+    for (int b = 0; b < numBars; b++)
+    {
+        float       fn = PatternBarNits(p, b);
+        long double t  = (numBars > 1) ? (long double)b / (long double)(numBars - 1) : 0.0L;
+        long double rn = startL + t * rangeL;
+
+        if (rn > 0.0L)
+        {
+            double rel = fabs((double)((long double)fn - rn) / (double)rn);
+            if (rel > st.maxRelNitsError) st.maxRelNitsError = rel;
+        }
+
+        // Label: digits the shader draws vs. the value rounded to 5 decimals
+        int fi, ff;
+        PatternLabelParts(fn, fi, ff);
+        long long total = llrintl(rn * 100000.0L);
+        int ri = (int)(total / 100000);
+        int rf = (int)(total % 100000);
+
+        // Only the low five fraction digits are drawn
+        int issues = 0;
+        if (fi != ri || ff % 100000 != rf) issues |= PRECISION_LABEL;
+
+        float    fs = PatternApplyPQ(fn / 10000.0f);
+        uint32_t fc = PatternUnorm10(fs);
+        double   fv = (double)fs * (double)PQ_CODE_MAX;
+        double   tie = fabs(fv - floor(fv) - 0.5);
+        uint32_t rc = (tie < REFERENCE_MARGIN || !(fs > 0.0f) || fs >= 1.0f) ? ReferenceCode((double)rn) : fc;
+        if (fc != rc)
+        {
+            issues |= PRECISION_CODE;
+            int err = (fc > rc) ? (int)(fc - rc) : (int)(rc - fc);
+            if (err > st.maxCodeError) st.maxCodeError = err;
+        }
+
+        if (!issues) continue;
+        if (issues & PRECISION_LABEL) { st.labelMismatches++; labelBars++; }
+        if (issues & PRECISION_CODE)  { st.codeMismatches++;  codeBars++; }
+
+        if (st.cases.size() < maxCases)
+        {
+            PrecisionCase c;
+            c.startNits = start;
+            c.endNits   = end;
+            c.numBars   = numBars;
+            c.barIdx    = b;
+            c.issues    = issues;
+            c.floatNits = fn;
+            c.refNits   = (double)rn;
+            c.floatInt  = fi;
+            c.floatFrac = ff;
+            c.refInt    = ri;
+            c.refFrac   = rf;
+            c.floatCode = fc;
+            c.refCode   = rc;
+            st.cases.push_back(c);
+        }
+    }
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// Scans
+// ---------------------------------------------------------------------------
+
+double PrecisionGridValue(double lo, double hi, int steps, int i)
+{
+    return (steps > 1) ? lo + (hi - lo) * (double)i / (double)(steps - 1) : lo;
+}
+
+bool RunPrecisionScan(const PrecisionGrid& grid, PrecisionReport& out, int maxCases, int workers)
+{
+    if (grid.startSteps < 1 || grid.endSteps < 1) return false;
+    if (grid.barsMin < 1 || grid.barsMax < grid.barsMin) return false;
+    if (maxCases < 0) maxCases = 0;
+
+    const size_t cells = (size_t)grid.startSteps * (size_t)grid.endSteps;
+    out.grid = grid;
+    out.labelMap.assign(cells, 0);
+    out.codeMap.assign(cells, 0);
+
+    // Bands of start values; each worker owns its rows of the maps
+    if (workers <= 0) workers = ParallelWorkerCount(grid.startSteps, 1);
+    std::vector<ScanState> states(workers);
+
+    ParallelForBands(grid.startSteps, workers, [&](int w, int s0, int s1)
+    {
+        ScanState& st = states[w];
+        st = ScanState();
+        st.cases.reserve((size_t)maxCases);
+
+        for (int si = s0; si < s1; si++)
+        {
+            double start = PrecisionGridValue(grid.startMin, grid.startMax, grid.startSteps, si);
+            for (int ei = 0; ei < grid.endSteps; ei++)
+            {
+                double   end = PrecisionGridValue(grid.endMin, grid.endMax, grid.endSteps, ei);
+                uint32_t labelBars = 0, codeBars = 0;
+                for (int n = grid.barsMin; n <= grid.barsMax; n++)
+                    EvaluateConfig(start, end, n, (size_t)maxCases, st, labelBars, codeBars);
+
+                size_t cell = (size_t)si * grid.endSteps + ei;
+                out.labelMap[cell] = labelBars;
+                out.codeMap[cell]  = codeBars;
+            }
+        }
+    });
+
+    // Merge in band order so the kept cases are the first in grid order
+    out.configs         = 0;
+    out.bars            = 0;
+    out.labelMismatches = 0;
+    out.codeMismatches  = 0;
+    out.maxCodeError    = 0;
+    out.maxRelNitsError = 0.0;
+    out.cases.clear();
+
+    for (const ScanState& st : states)
+    {
+        out.configs         += st.configs;
+        out.bars            += st.bars;
+        out.labelMismatches += st.labelMismatches;
+        out.codeMismatches  += st.codeMismatches;
+        if (st.maxCodeError > out.maxCodeError)       out.maxCodeError    = st.maxCodeError;
+        if (st.maxRelNitsError > out.maxRelNitsError) out.maxRelNitsError = st.maxRelNitsError;
+        for (const PrecisionCase& c : st.cases)
+            if (out.cases.size() < (size_t)maxCases) out.cases.push_back(c);
+    }
+    return true;
+}
+
+bool CheckPatternPrecision(const PatternParams& p, PrecisionReport& out, int maxCases)
+{
+    PrecisionGrid grid = { p.startNits, p.startNits, 1, p.endNits, p.endNits, 1, p.numBars, p.numBars };
+    return RunPrecisionScan(grid, out, maxCases, 1);
+}
+
+// ---------------------------------------------------------------------------
+// Reporting
+// ---------------------------------------------------------------------------
+
+std::string FormatPrecisionReport(const PrecisionReport& r, int maxLines)
+{
+    std::string s;
+    char line[192];
+
+    snprintf(line, sizeof(line),
+        "Configurations: %llu (%llu bars)\n"
+        "Label mismatches: %llu\nCode mismatches: %llu, worst %d code(s)\n"
+        "Worst relative luminance error: %.3g\n",
+        (unsigned long long)r.configs, (unsigned long long)r.bars,
+        (unsigned long long)r.labelMismatches,
+        (unsigned long long)r.codeMismatches, r.maxCodeError,
+        r.maxRelNitsError);
+    s += line;
+
+    if (r.cases.empty()) return s;
+
+    s += "\nStart      End        Bars Bar  Float nits   Ref nits       Label float/ref    Code float/ref\n";
+    int lines = 0;
+    for (const PrecisionCase& c : r.cases)
+    {
+        if (lines++ >= maxLines) { s += "...\n"; break; }
+        char floatLabel[24], refLabel[24];
+        snprintf(floatLabel, sizeof(floatLabel), "%d.%05d", c.floatInt, c.floatFrac % 100000);
+        snprintf(refLabel,   sizeof(refLabel),   "%d.%05d", c.refInt, c.refFrac);
+        snprintf(line, sizeof(line), "%-10.7g %-10.7g %-4d %-4d %-12.9g %-14.11g %s%s/%s%s %u/%u%s\n",
+            c.startNits, c.endNits, c.numBars, c.barIdx, c.floatNits, c.refNits,
+            (c.issues & PRECISION_LABEL) ? "*" : " ", floatLabel, refLabel,
+            (c.issues & PRECISION_LABEL) ? "*" : " ",
+            c.floatCode, c.refCode, (c.issues & PRECISION_CODE) ? " *" : "");
+        s += line;
+    }
+    return s;
+}
+
+bool WritePrecisionMap(const PrecisionReport& r, PrecisionIssue issue, const char* path)
+{
+    const std::vector<uint32_t>& map = (issue == PRECISION_LABEL) ? r.labelMap : r.codeMap;
+    const size_t cells = (size_t)r.grid.startSteps * (size_t)r.grid.endSteps;
+    if (map.size() != cells) return false;
+
+    // Counts saturate at 255; the ramp spans the worst cell
+    std::vector<uint8_t> heat(cells);
+    int maxValue = 0;
+    for (size_t i = 0; i < cells; i++)
+    {
+        heat[i] = (uint8_t)(map[i] < 255u ? map[i] : 255u);
+        if (heat[i] > maxValue) maxValue = heat[i];
+    }
+    return WriteHeatmap(heat.data(), r.grid.endSteps, r.grid.startSteps, maxValue, path);
+}
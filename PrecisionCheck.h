@@ -0,0 +1,83 @@
+#pragma once
+
+// ---------------------------------------------------------------------------
+// PrecisionCheck
+//
+// Compares the shader's 32-bit float math for every bar of a pattern (bar
+// luminance lerp, label digits, PQ code) against a high-precision reference:
+// the lerp and label rounding in long double, the PQ curve in double. Inputs
+// are taken as the reference values; the float path sees them rounded to
+// float, as the toolbar and cbuffer do, so input quantization is covered too.
+//
+// Scans sweep a grid of start / end luminance and bar counts in parallel
+// (bands of start values per worker) and report every bar whose label text
+// or 10-bit code differs from the reference, plus per-(start, end) error
+// maps.
+// ---------------------------------------------------------------------------
+
+#include "PatternCore.h"
+
+#include <string>
+#include <vector>
+
+struct PrecisionGrid
+{
+    double startMin, startMax;
+    int    startSteps;          // 1 = startMin only
+    double endMin, endMax;
+    int    endSteps;
+    int    barsMin, barsMax;    // every bar count in [barsMin, barsMax]
+};
+
+enum PrecisionIssue
+{
+    PRECISION_LABEL = 1,        // label text differs from the correctly rounded value
+    PRECISION_CODE  = 2         // 10-bit PQ code differs from the reference
+};
+
+struct PrecisionCase
+{
+    double   startNits;
+    double   endNits;
+    int      numBars;
+    int      barIdx;
+    int      issues;            // PrecisionIssue bits
+    float    floatNits;
+    double   refNits;
+    int      floatInt, floatFrac;   // label as the shader draws it
+    int      refInt,   refFrac;     // reference rounded to 5 decimals
+    uint32_t floatCode;
+    uint32_t refCode;
+};
+
+struct PrecisionReport
+{
+    PrecisionGrid              grid;
+    uint64_t                   configs;
+    uint64_t                   bars;
+    uint64_t                   labelMismatches;
+    uint64_t                   codeMismatches;
+    int                        maxCodeError;
+    double                     maxRelNitsError;     // |float - ref| / ref over all bars
+    std::vector<PrecisionCase> cases;               // first divergences, in grid order
+
+    // endSteps x startSteps (x = end, y = start): mismatching bars summed
+    // over all bar counts
+    std::vector<uint32_t>      labelMap;
+    std::vector<uint32_t>      codeMap;
+};
+
+// Grid value `i` of `steps` evenly spaced values in [lo, hi]
+double PrecisionGridValue(double lo, double hi, int steps, int i);
+
+// Returns false if the grid is empty or invalid. `workers` <= 0 picks a
+// thread count automatically.
+bool RunPrecisionScan(const PrecisionGrid& grid, PrecisionReport& out, int maxCases = 32, int workers = 0);
+
+// Single configuration, e.g. the frame on screen
+bool CheckPatternPrecision(const PatternParams& p, PrecisionReport& out, int maxCases = 32);
+
+std::string FormatPrecisionReport(const PrecisionReport& r, int maxLines = 24);
+
+// Writes the label or code map as a heatmap PPM (see WriteHeatmap)
+bool WritePrecisionMap(const PrecisionReport& r, PrecisionIssue issue, const char* path);
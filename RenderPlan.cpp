@@ -0,0 +1,240 @@
+#include "RenderPlan.h"
+#include "Parallel.h"
+#include "SpanFill.h"
+#include "SpanLayout.h"
+
+#include <algorithm>
+#include <cstring>
+
+// ---------------------------------------------------------------------------
+// Compilation
+// ---------------------------------------------------------------------------
+
+namespace
+{
+
+// Scanlines of the shader's bar layout, with `layout` in place of its constants
+class BarRasterizer
+{
+public:
+    BarRasterizer(const PatternParams& p, const PatternLayout& layout)
+        : m_p(p), m_layout(layout)
+    {
+        m_format  = (FrameFormat)p.outputMode;
+        m_black   = PatternPackTexel(m_format, 0.0f);
+        m_label   = PatternPackTexel(m_format, p.labelNits);
+        m_labelW  = (std::min)(p.width, PatternLabelW(layout));
+        m_cellH   = PatternCellH(layout);
+
+        // Widest label: 10 integer digits + '.' + 5 fractional
+        m_textEnd = layout.labels ? (std::min)(p.width, layout.labelX + 16 * PatternCellW(layout)) : 0;
+    }
+
+    void Row(int y, std::vector<LayoutSpan>& row)
+    {
+        PatternRow info = PatternClassifyRow(m_p, m_layout, y);
+        row.clear();
+
+        if (info.isSep)
+        {
+            AppendLayoutSpan(row, 0, m_p.width, m_black, 0.0f);
+            return;
+        }
+
+        if (info.barIdx != m_cachedBar)
+        {
+            m_cachedBar = info.barIdx;
+            m_barNits   = PatternBarNits(m_p, m_cachedBar);
+            m_barTexel  = PatternPackTexel(m_format, m_barNits);
+        }
+
+        int ly = y - info.labelY;
+        if (m_textEnd > 0 && ly >= 0 && ly < m_cellH)
+        {
+            // Glyph pixels become spans; the background under them is the
+            // label column or the bar, as in the shader.
+            for (int x = 0; x < m_textEnd; x++)
+            {
+                bool lit = (x >= m_layout.labelX)
+                    && PatternSampleValue(m_barNits, x, y, m_layout.labelX, info.labelY, m_layout.fontScale);
+                if (lit)
+                    AppendLayoutSpan(row, x, x + 1, m_label, m_p.labelNits);
+                else if (x < m_labelW)
+                    AppendLayoutSpan(row, x, x + 1, m_black, 0.0f);
+                else
+                    AppendLayoutSpan(row, x, x + 1, m_barTexel, m_barNits);
+            }
+            AppendLayoutSpan(row, m_textEnd, m_labelW, m_black, 0.0f);
+            AppendLayoutSpan(row, (std::max)(m_textEnd, m_labelW), m_p.width, m_barTexel, m_barNits);
+        }
+        else
+        {
+            AppendLayoutSpan(row, 0, m_labelW, m_black, 0.0f);
+            AppendLayoutSpan(row, m_labelW, m_p.width, m_barTexel, m_barNits);
+        }
+    }
+
+private:
+    const PatternParams& m_p;
+    const PatternLayout& m_layout;
+    FrameFormat          m_format;
+    uint64_t             m_black, m_label;
+    int                  m_labelW, m_cellH, m_textEnd;
+    int                  m_cachedBar = -1;
+    float                m_barNits   = 0.0f;
+    uint64_t             m_barTexel  = 0;
+};
+
+bool SameSpans(const PlanSpan* a, const LayoutSpan* b, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        if (a[i].x0 != b[i].x0 || a[i].x1 != b[i].x1 || a[i].texel != b[i].texel)
+            return false;
+    }
+    return true;
+}
+
+} // namespace
+
+template<typename Rasterizer>
+void RenderPlan::Build(Rasterizer& rasterizer)
+{
+    m_groups.clear();
+    m_spans.clear();
+
+    double nitsSum = 0.0;
+    std::vector<LayoutSpan> row;
+
+    for (int y = 0; y < m_params.height; y++)
+    {
+        rasterizer.Row(y, row);
+        for (const LayoutSpan& s : row)
+            nitsSum += (double)s.nits * (double)(s.x1 - s.x0);
+
+        if (!m_groups.empty())
+        {
+            PlanRowGroup& last = m_groups.back();
+            if (last.spanCount == row.size() && SameSpans(&m_spans[last.firstSpan], row.data(), row.size()))
+            {
+                last.y1 = y + 1;
+                continue;
+            }
+        }
+
+        m_groups.push_back(PlanRowGroup{ y, y + 1, (uint32_t)m_spans.size(), (uint32_t)row.size() });
+        for (const LayoutSpan& s : row)
+            m_spans.push_back(PlanSpan{ s.x0, s.x1, s.texel });
+    }
+
+    m_groups.shrink_to_fit();
+    m_spans.shrink_to_fit();
+    m_averageNits = nitsSum / ((double)m_params.width * (double)m_params.height);
+}
+
+bool RenderPlan::Compile(const PatternDesc& desc, int width, int height, RenderPlan& plan, std::string* error)
+{
+    PatternParams p = desc.params;
+    if (p.width  <= 0) p.width  = width;
+    if (p.height <= 0) p.height = height;
+
+    if (p.width <= 0 || p.height <= 0 || p.numBars < 1)
+    {
+        if (error) *error = desc.name + ": no target size";
+        return false;
+    }
+
+    plan.m_name   = desc.name;
+    plan.m_params = p;
+    plan.m_params.barNits = nullptr;
+
+    if (desc.kind == PATTERN_SHAPES)
+    {
+        ShapeRasterizer rasterizer(desc, p.width, p.height);
+        plan.Build(rasterizer);
+    }
+    else
+    {
+        // The spacing schedule only lives for the build; its luminances end
+        // up in the span texels
+        std::vector<float> barNits;
+        if (desc.spacing != BAR_SPACING_LINEAR)
+        {
+            if (!BuildBarSchedule(desc.spacing, p, desc.levels, barNits, error))
+            {
+                if (error) *error = desc.name + ": " + *error;
+                return false;
+            }
+            p.barNits = barNits.data();
+        }
+
+        BarRasterizer rasterizer(p, desc.layout);
+        plan.Build(rasterizer);
+    }
+    return true;
+}
+
+size_t RenderPlan::GroupForRow(int y) const
+{
+    auto it = std::upper_bound(m_groups.begin(), m_groups.end(), y,
+        [](int row, const PlanRowGroup& g) { return row < g.y1; });
+    return (size_t)(it - m_groups.begin());
+}
+
+// ---------------------------------------------------------------------------
+// Rendering
+// ---------------------------------------------------------------------------
+
+namespace
+{
+
+template<typename Texel>
+void FillRow(const PlanSpan* spans, uint32_t count, uint8_t* dst)
+{
+    Texel* row = (Texel*)dst;
+    for (uint32_t i = 0; i < count; i++)
+        FillSpan(row, spans[i].x0, spans[i].x1, (Texel)spans[i].texel);
+}
+
+} // namespace
+
+void RenderPlanRows(const RenderPlan& plan, void* dst, size_t rowPitch, int y0, int y1)
+{
+    const std::vector<PlanRowGroup>& groups = plan.Groups();
+    const PlanSpan* spans = plan.Spans().data();
+    const bool   packed32 = (plan.Format() == FRAME_R10G10B10A2);
+    const size_t rowBytes = (size_t)plan.Width() * FrameBytesPerPixel(plan.Format());
+
+    if (y1 > plan.Height()) y1 = plan.Height();
+    uint8_t* out = (uint8_t*)dst;
+
+    // Each group's first row in the band is filled from spans; the rest of
+    // the group is a copy of that row.
+    for (size_t g = plan.GroupForRow(y0); g < groups.size() && y0 < y1; g++)
+    {
+        const PlanRowGroup& group = groups[g];
+        int end = (std::min)(group.y1, y1);
+
+        uint8_t* first = out;
+        if (packed32)
+            FillRow<uint32_t>(spans + group.firstSpan, group.spanCount, first);
+        else
+            FillRow<uint64_t>(spans + group.firstSpan, group.spanCount, first);
+
+        for (int y = y0 + 1; y < end; y++)
+            memcpy(first + (size_t)(y - y0) * rowPitch, first, rowBytes);
+
+        out += (size_t)(end - y0) * rowPitch;
+        y0 = end;
+    }
+}
+
+void RenderPlanFrame(const RenderPlan& plan, void* dst, size_t rowPitch, int workers)
+{
+    if (workers <= 0) workers = ParallelWorkerCount(plan.Height(), 128);
+
+    ParallelForBands(plan.Height(), workers, [&](int, int y0, int y1)
+    {
+        RenderPlanRows(plan, (uint8_t*)dst + (size_t)y0 * rowPitch, rowPitch, y0, y1);
+    });
+}
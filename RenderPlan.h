@@ -0,0 +1,77 @@
+#pragma once
+
+// ---------------------------------------------------------------------------
+// RenderPlan
+//
+// A pattern description compiled for one target size: every scanline as a
+// list of constant-texel spans, with runs of identical scanlines folded into
+// row groups. All layout decisions (separators, label column, glyph pixels,
+// shapes, PQ / half encoding) are made at compile time, so rendering a plan
+// is SSE2 span fills plus row copies with no per-pixel branching.
+//
+// A compiled plan is immutable and may be rendered from any number of threads
+// at once.
+// ---------------------------------------------------------------------------
+
+#include "PatternDesc.h"
+
+#include <string>
+#include <vector>
+
+// Texels [x0, x1) of a scanline; 32-bit formats use the low half of `texel`
+struct PlanSpan
+{
+    int      x0;
+    int      x1;
+    uint64_t texel;
+};
+
+// Scanlines [y0, y1) are identical and consist of spans
+// [firstSpan, firstSpan + spanCount), which cover the row left to right.
+struct PlanRowGroup
+{
+    int      y0;
+    int      y1;
+    uint32_t firstSpan;
+    uint32_t spanCount;
+};
+
+class RenderPlan
+{
+public:
+    // Compiles `desc` at width x height; a size in the description wins.
+    static bool Compile(const PatternDesc& desc, int width, int height, RenderPlan& plan, std::string* error);
+
+    const std::string&               Name() const    { return m_name; }
+    // Resolved size. barNits is always null: a spacing schedule is baked
+    // into the spans at compile time.
+    const PatternParams&             Params() const  { return m_params; }
+    FrameFormat                      Format() const  { return (FrameFormat)m_params.outputMode; }
+    int                              Width() const   { return m_params.width; }
+    int                              Height() const  { return m_params.height; }
+    const std::vector<PlanRowGroup>& Groups() const  { return m_groups; }
+    const std::vector<PlanSpan>&     Spans() const   { return m_spans; }
+
+    // Index of the group containing scanline y
+    size_t                           GroupForRow(int y) const;
+
+    // Mean luminance over the frame (average picture level), nits
+    double                           AverageNits() const { return m_averageNits; }
+
+private:
+    template<typename Rasterizer>
+    void Build(Rasterizer& rasterizer);
+
+    std::string               m_name;
+    PatternParams             m_params = {};
+    std::vector<PlanRowGroup> m_groups;
+    std::vector<PlanSpan>     m_spans;
+    double                    m_averageNits = 0.0;
+};
+
+// Renders into `dst` (rowPitch bytes per scanline). `workers` <= 0 picks a
+// thread count automatically; 1 renders on the calling thread.
+void RenderPlanFrame(const RenderPlan& plan, void* dst, size_t rowPitch, int workers = 0);
+
+// Renders scanlines [y0, y1) only; `dst` points at scanline y0.
+void RenderPlanRows(const RenderPlan& plan, void* dst, size_t rowPitch, int y0, int y1);
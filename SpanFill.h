@@ -0,0 +1,47 @@
+#pragma once
+
+// ---------------------------------------------------------------------------
+// SpanFill
+//
+// Constant-texel run fill shared by the span renderers (RenderPlan,
+// SpanFrame). Texel is uint32_t (R10G10B10A2) or uint64_t (RGBA16F).
+// ---------------------------------------------------------------------------
+
+#include <cstdint>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define SPANFILL_SSE2 1
+#endif
+
+// Fills [x0, x1) of a scanline with one texel, 16 bytes per store
+template<typename Texel>
+inline void FillSpan(Texel* row, int x0, int x1, Texel texel)
+{
+    Texel* p   = row + x0;
+    Texel* end = row + x1;
+
+#ifdef SPANFILL_SSE2
+    const int perVec = 16 / (int)sizeof(Texel);
+    if (end - p >= 2 * perVec)
+    {
+        __m128i v = (sizeof(Texel) == 4) ? _mm_set1_epi32((int)(uint32_t)texel)
+                                          : _mm_set1_epi64x((long long)texel);
+
+        // Scalar head up to 16-byte alignment, then aligned stores. Frame rows
+        // are at least texel-aligned, so the head is at most 3 texels.
+        while (((uintptr_t)p & 15) && p < end) *p++ = texel;
+        for (; end - p >= 4 * perVec; p += 4 * perVec)
+        {
+            _mm_store_si128((__m128i*)p,                v);
+            _mm_store_si128((__m128i*)(p + perVec),     v);
+            _mm_store_si128((__m128i*)(p + 2 * perVec), v);
+            _mm_store_si128((__m128i*)(p + 3 * perVec), v);
+        }
+        for (; end - p >= perVec; p += perVec)
+            _mm_store_si128((__m128i*)p, v);
+    }
+#endif
+
+    while (p < end) *p++ = texel;
+}
@@ -0,0 +1,509 @@
+#include "SpanFrame.h"
+#include "Parallel.h"
+#include "RenderPlan.h"
+#include "SpanFill.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+// ---------------------------------------------------------------------------
+// Format constants / helpers
+// ---------------------------------------------------------------------------
+
+namespace
+{
+
+const uint32_t SPAN_FRAME_MAGIC   = 0x50535150; // "PQSP"
+const uint32_t SPAN_TRAILER_MAGIC = 0x45535150; // "PQSE"
+const uint16_t SPAN_FRAME_VERSION = 1;
+const size_t   SPAN_HEADER_BYTES  = 16;
+const size_t   SPAN_TRAILER_BYTES = 16;
+const size_t   SPAN_INDEX_BYTES   = 12;
+const size_t   SPAN_SINK_BYTES    = 64 * 1024;  // encoder hands data over in blocks this size
+const int      SPAN_MAX_SIZE      = 16384;
+
+uint32_t ReadU32(const uint8_t* p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+uint64_t ReadU64(const uint8_t* p)
+{
+    return (uint64_t)ReadU32(p) | ((uint64_t)ReadU32(p + 4) << 32);
+}
+
+void StoreU32(uint8_t* p, uint32_t v)
+{
+    p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); p[2] = (uint8_t)(v >> 16); p[3] = (uint8_t)(v >> 24);
+}
+
+void StoreU64(uint8_t* p, uint64_t v)
+{
+    StoreU32(p, (uint32_t)v);
+    StoreU32(p + 4, (uint32_t)(v >> 32));
+}
+
+// Bounds-checked record cursor for the decoder
+struct Cursor
+{
+    const uint8_t* p;
+    const uint8_t* end;
+
+    bool Varint(uint64_t& v)
+    {
+        v = 0;
+        for (int shift = 0; shift < 64 && p < end; shift += 7)
+        {
+            uint8_t b = *p++;
+            v |= (uint64_t)(b & 0x7F) << shift;
+            if (!(b & 0x80)) return true;
+        }
+        return false;
+    }
+
+    bool Texel(size_t bytes, uint64_t& v)
+    {
+        if ((size_t)(end - p) < bytes) return false;
+        v = (bytes == 4) ? ReadU32(p) : ReadU64(p);
+        p += bytes;
+        return true;
+    }
+};
+
+// Splits a scanline into (length, texel) runs. Whole 16-byte blocks that
+// continue the current run are skipped with one SSE2 compare.
+template<typename Texel>
+void ScanRuns(const Texel* row, int width, std::vector<std::pair<int, uint64_t>>& runs)
+{
+    runs.clear();
+    int x = 0;
+    while (x < width)
+    {
+        const Texel t = row[x];
+        int e = x + 1;
+
+#ifdef SPANFILL_SSE2
+        const int perVec = 16 / (int)sizeof(Texel);
+        __m128i v = (sizeof(Texel) == 4) ? _mm_set1_epi32((int)(uint32_t)t)
+                                          : _mm_set1_epi64x((long long)t);
+        while (e + perVec <= width
+            && _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(row + e)), v)) == 0xFFFF)
+            e += perVec;
+#endif
+
+        while (e < width && row[e] == t) e++;
+        runs.push_back(std::make_pair(e - x, (uint64_t)t));
+        x = e;
+    }
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// Texel conversion
+// ---------------------------------------------------------------------------
+
+uint64_t ConvertTexel(uint64_t texel, FrameFormat from, FrameFormat to)
+{
+    if (from == to) return texel;
+
+    if (from == FRAME_R10G10B10A2)
+    {
+        // PQ code -> linear scRGB (1.0 = 80 nits)
+        uint64_t out = 0;
+        for (int c = 0; c < 3; c++)
+        {
+            uint32_t code = (uint32_t)(texel >> (10 * c)) & 0x3FFu;
+            double nits = PatternPQDecode((double)code / (double)PQ_CODE_MAX);
+            out |= (uint64_t)FloatToHalf((float)(nits / 80.0)) << (16 * c);
+        }
+        uint32_t alpha = (uint32_t)(texel >> 30) & 3u;
+        return out | ((uint64_t)FloatToHalf((float)alpha / 3.0f) << 48);
+    }
+
+    const uint16_t* lut = HalfToPQCodeTable();
+    uint32_t out = 0;
+    for (int c = 0; c < 3; c++)
+        out |= (uint32_t)lut[(texel >> (16 * c)) & 0xFFFFu] << (10 * c);
+
+    float a = HalfToFloat((uint16_t)(texel >> 48));
+    uint32_t alpha = !(a > 0.0f) ? 0u : (a >= 1.0f ? 3u : (uint32_t)(a * 3.0f + 0.5f));
+    return out | (alpha << 30);
+}
+
+// ---------------------------------------------------------------------------
+// Encoder
+// ---------------------------------------------------------------------------
+
+SpanFrameEncoder::SpanFrameEncoder(FrameFormat format, int width, int height, Sink sink)
+    : m_format(format), m_width(width), m_height(height),
+      m_texelBytes(FrameBytesPerPixel(format)), m_sink(sink)
+{
+    uint8_t header[SPAN_HEADER_BYTES];
+    StoreU32(header, SPAN_FRAME_MAGIC);
+    header[4] = (uint8_t)SPAN_FRAME_VERSION;
+    header[5] = (uint8_t)(SPAN_FRAME_VERSION >> 8);
+    header[6] = (uint8_t)format;
+    header[7] = 0;
+    StoreU32(header + 8,  (uint32_t)width);
+    StoreU32(header + 12, (uint32_t)height);
+    PutBytes(header, sizeof(header));
+
+    m_pendingRow.resize((size_t)width * m_texelBytes);
+}
+
+void SpanFrameEncoder::PutVarint(uint64_t v)
+{
+    while (v >= 0x80)
+    {
+        m_buffer.push_back((uint8_t)(v | 0x80));
+        v >>= 7;
+    }
+    m_buffer.push_back((uint8_t)v);
+}
+
+void SpanFrameEncoder::PutBytes(const void* data, size_t size)
+{
+    const uint8_t* b = (const uint8_t*)data;
+    m_buffer.insert(m_buffer.end(), b, b + size);
+}
+
+void SpanFrameEncoder::BeginGroup(int y0, int rows, size_t spanCount)
+{
+    m_index.push_back(IndexEntry{ y0, m_written + m_buffer.size() });
+    PutVarint((uint64_t)rows);
+    PutVarint((uint64_t)spanCount);
+}
+
+void SpanFrameEncoder::PutTexel(uint64_t texel)
+{
+    uint8_t bytes[8];
+    StoreU64(bytes, texel);
+    PutBytes(bytes, m_texelBytes);
+}
+
+bool SpanFrameEncoder::Drain(bool force)
+{
+    if (m_failed) return false;
+    if (m_buffer.empty() || (!force && m_buffer.size() < SPAN_SINK_BYTES)) return true;
+
+    if (!m_sink(m_buffer.data(), m_buffer.size()))
+    {
+        m_failed = true;
+        return false;
+    }
+    m_written += m_buffer.size();
+    m_buffer.clear();
+    return true;
+}
+
+void SpanFrameEncoder::FlushPending()
+{
+    if (m_pendingRows == 0) return;
+
+    if (m_format == FRAME_R10G10B10A2)
+        ScanRuns((const uint32_t*)m_pendingRow.data(), m_width, m_runs);
+    else
+        ScanRuns((const uint64_t*)m_pendingRow.data(), m_width, m_runs);
+
+    BeginGroup(m_pendingY0, m_pendingRows, m_runs.size());
+    for (size_t i = 0; i < m_runs.size(); i++)
+    {
+        bool reuse = (i >= 2) && m_runs[i - 2].second == m_runs[i].second;
+        PutVarint(((uint64_t)m_runs[i].first << 1) | (reuse ? 1u : 0u));
+        if (!reuse) PutTexel(m_runs[i].second);
+    }
+
+    m_pendingRows = 0;
+}
+
+bool SpanFrameEncoder::AddRows(const void* data, size_t rowPitch, int count)
+{
+    const size_t rowBytes = m_pendingRow.size();
+
+    for (int r = 0; r < count; r++)
+    {
+        if (m_rowsAdded >= m_height) return false;
+        const uint8_t* row = (const uint8_t*)data + (size_t)r * rowPitch;
+
+        if (m_pendingRows > 0 && memcmp(row, m_pendingRow.data(), rowBytes) == 0)
+        {
+            m_pendingRows++;
+        }
+        else
+        {
+            FlushPending();
+            memcpy(m_pendingRow.data(), row, rowBytes);
+            m_pendingY0   = m_rowsAdded;
+            m_pendingRows = 1;
+        }
+        m_rowsAdded++;
+
+        if (!Drain(false)) return false;
+    }
+    return true;
+}
+
+bool SpanFrameEncoder::AddPlan(const RenderPlan& plan)
+{
+    if (m_rowsAdded != 0 || plan.Width() != m_width || plan.Height() != m_height || plan.Format() != m_format)
+        return false;
+
+    const std::vector<PlanSpan>& spans = plan.Spans();
+    for (const PlanRowGroup& g : plan.Groups())
+    {
+        BeginGroup(g.y0, g.y1 - g.y0, g.spanCount);
+        for (uint32_t i = 0; i < g.spanCount; i++)
+        {
+            const PlanSpan& s = spans[g.firstSpan + i];
+            bool reuse = (i >= 2) && spans[g.firstSpan + i - 2].texel == s.texel;
+            PutVarint(((uint64_t)(s.x1 - s.x0) << 1) | (reuse ? 1u : 0u));
+            if (!reuse) PutTexel(s.texel);
+        }
+        if (!Drain(false)) return false;
+    }
+    m_rowsAdded = m_height;
+    return true;
+}
+
+bool SpanFrameEncoder::Finish()
+{
+    FlushPending();
+    if (m_failed || m_rowsAdded != m_height) return false;
+
+    PutVarint(0);
+
+    uint64_t indexOffset = m_written + m_buffer.size();
+    for (const IndexEntry& e : m_index)
+    {
+        uint8_t entry[SPAN_INDEX_BYTES];
+        StoreU32(entry, (uint32_t)e.y0);
+        StoreU64(entry + 4, e.offset);
+        PutBytes(entry, sizeof(entry));
+    }
+
+    uint8_t trailer[SPAN_TRAILER_BYTES];
+    StoreU64(trailer, indexOffset);
+    StoreU32(trailer + 8, (uint32_t)m_index.size());
+    StoreU32(trailer + 12, SPAN_TRAILER_MAGIC);
+    PutBytes(trailer, sizeof(trailer));
+
+    return Drain(true);
+}
+
+// ---------------------------------------------------------------------------
+// Reader
+// ---------------------------------------------------------------------------
+
+bool SpanFrameReader::Open(const uint8_t* data, size_t size, std::string* error)
+{
+    m_data = nullptr;
+    m_size = 0;
+    m_index.clear();
+
+    auto fail = [&](const char* reason)
+    {
+        if (error) *error = reason;
+        m_index.clear();
+        return false;
+    };
+
+    if (size < SPAN_HEADER_BYTES + 1 + SPAN_TRAILER_BYTES || ReadU32(data) != SPAN_FRAME_MAGIC)
+        return fail("not a span frame");
+    if ((data[4] | (data[5] << 8)) != SPAN_FRAME_VERSION)
+        return fail("unsupported span frame version");
+
+    uint32_t format = data[6];
+    uint32_t width  = ReadU32(data + 8);
+    uint32_t height = ReadU32(data + 12);
+    if ((format != FRAME_R10G10B10A2 && format != FRAME_RGBA16F)
+        || width == 0 || height == 0 || width > (uint32_t)SPAN_MAX_SIZE || height > (uint32_t)SPAN_MAX_SIZE)
+        return fail("bad span frame header");
+
+    const uint8_t* trailer = data + size - SPAN_TRAILER_BYTES;
+    uint64_t indexOffset = ReadU64(trailer);
+    uint32_t groupCount  = ReadU32(trailer + 8);
+    if (ReadU32(trailer + 12) != SPAN_TRAILER_MAGIC)
+        return fail("span frame truncated (no trailer)");
+    // Subtract rather than add so a huge offset cannot wrap into range
+    const uint64_t indexEnd = size - SPAN_TRAILER_BYTES;
+    if (groupCount == 0 || groupCount > height || indexOffset < SPAN_HEADER_BYTES || indexOffset > indexEnd
+        || indexEnd - indexOffset != (uint64_t)groupCount * SPAN_INDEX_BYTES)
+        return fail("bad span frame index");
+
+    m_index.resize(groupCount);
+    for (uint32_t i = 0; i < groupCount; i++)
+    {
+        const uint8_t* e = data + indexOffset + (size_t)i * SPAN_INDEX_BYTES;
+        m_index[i].y0     = (int)ReadU32(e);
+        m_index[i].offset = ReadU64(e + 4);
+
+        bool ordered = (i == 0) ? (m_index[i].y0 == 0)
+            : (m_index[i].y0 > m_index[i - 1].y0 && m_index[i].offset > m_index[i - 1].offset);
+        if (!ordered || m_index[i].y0 >= (int)height || m_index[i].offset >= indexOffset)
+            return fail("bad span frame index");
+    }
+
+    m_data   = data;
+    m_size   = (size_t)indexOffset;     // records end where the index starts
+    m_width  = (int)width;
+    m_height = (int)height;
+    m_format = (FrameFormat)format;
+    return true;
+}
+
+namespace
+{
+
+// Decodes one group record into `row`; `rows` receives its row count
+template<typename Texel>
+bool DecodeGroup(Cursor& c, FrameFormat stored, FrameFormat target, int width, Texel* row, uint64_t& rows)
+{
+    const size_t texelBytes = FrameBytesPerPixel(stored);
+
+    uint64_t spanCount;
+    if (!c.Varint(rows) || rows == 0 || !c.Varint(spanCount) || spanCount == 0 || spanCount > (uint64_t)width)
+        return false;
+
+    // Stored and converted texels of the previous two spans ([0] = two
+    // back). Spans alternate between a handful of values, so each distinct
+    // texel is converted about once per group.
+    uint64_t raw[2] = { 0, 0 };
+    Texel    out[2] = { 0, 0 };
+    int x = 0;
+
+    for (uint64_t i = 0; i < spanCount; i++)
+    {
+        uint64_t v;
+        if (!c.Varint(v)) return false;
+        uint64_t length = v >> 1;
+        if (length == 0 || length > (uint64_t)(width - x)) return false;
+
+        uint64_t t;
+        Texel texel;
+        if (v & 1)
+        {
+            if (i < 2) return false;
+            t     = raw[0];
+            texel = out[0];
+        }
+        else
+        {
+            if (!c.Texel(texelBytes, t)) return false;
+            if      (i >= 2 && t == raw[0]) texel = out[0];
+            else if (i >= 1 && t == raw[1]) texel = out[1];
+            else                            texel = (Texel)ConvertTexel(t, stored, target);
+        }
+
+        raw[0] = raw[1]; out[0] = out[1];
+        raw[1] = t;      out[1] = texel;
+
+        FillSpan(row, x, x + (int)length, texel);
+        x += (int)length;
+    }
+    return x == width;
+}
+
+} // namespace
+
+bool SpanFrameReader::DecodeRows(int y0, int y1, void* dst, size_t rowPitch, FrameFormat target) const
+{
+    if (!m_data || y0 < 0 || y1 > m_height || y0 > y1) return false;
+
+    const size_t rowBytes = (size_t)m_width * FrameBytesPerPixel(target);
+    uint8_t* out = (uint8_t*)dst;
+
+    // Group containing y0
+    size_t g = (size_t)(std::upper_bound(m_index.begin(), m_index.end(), y0,
+        [](int y, const IndexEntry& e) { return y < e.y0; }) - m_index.begin()) - 1;
+
+    for (; g < m_index.size() && y0 < y1; g++)
+    {
+        int groupEnd = (g + 1 < m_index.size()) ? m_index[g + 1].y0 : m_height;
+
+        Cursor c = { m_data + m_index[g].offset, m_data + m_size };
+        uint64_t rows;
+        bool ok = (target == FRAME_R10G10B10A2)
+            ? DecodeGroup(c, m_format, target, m_width, (uint32_t*)out, rows)
+            : DecodeGroup(c, m_format, target, m_width, (uint64_t*)out, rows);
+        if (!ok || rows != (uint64_t)(groupEnd - m_index[g].y0)) return false;
+
+        int end = (std::min)(groupEnd, y1);
+        for (int y = y0 + 1; y < end; y++)
+            memcpy(out + (size_t)(y - y0) * rowPitch, out, rowBytes);
+
+        out += (size_t)(end - y0) * rowPitch;
+        y0 = end;
+    }
+    return y0 == y1;
+}
+
+bool SpanFrameReader::DecodeFrame(void* dst, size_t rowPitch, FrameFormat target, int workers) const
+{
+    if (!m_data) return false;
+    if (workers <= 0) workers = ParallelWorkerCount(m_height, 256);
+
+    std::vector<char> ok((size_t)workers, 1);
+    ParallelForBands(m_height, workers, [&](int worker, int y0, int y1)
+    {
+        ok[worker] = DecodeRows(y0, y1, (uint8_t*)dst + (size_t)y0 * rowPitch, rowPitch, target);
+    });
+    return std::find(ok.begin(), ok.end(), 0) == ok.end();
+}
+
+// ---------------------------------------------------------------------------
+// Whole frames
+// ---------------------------------------------------------------------------
+
+bool EncodeSpanFrame(const FrameView& frame, std::vector<uint8_t>& out)
+{
+    SpanFrameEncoder encoder(frame.format, frame.width, frame.height,
+        [&](const uint8_t* data, size_t size)
+        {
+            out.insert(out.end(), data, data + size);
+            return true;
+        });
+    return encoder.AddRows(frame.data, frame.rowPitch, frame.height) && encoder.Finish();
+}
+
+bool SaveSpanFrame(const char* path, const FrameView& frame)
+{
+    FILE* f = fopen(path, "wb");
+    if (!f) return false;
+
+    SpanFrameEncoder encoder(frame.format, frame.width, frame.height,
+        [&](const uint8_t* data, size_t size)
+        {
+            return fwrite(data, 1, size, f) == size;
+        });
+    bool ok = encoder.AddRows(frame.data, frame.rowPitch, frame.height) && encoder.Finish();
+    return (fclose(f) == 0) && ok;
+}
+
+bool LoadSpanFrame(const char* path, std::vector<uint8_t>& storage, FrameView& frame)
+{
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+
+    std::vector<uint8_t> bytes;
+    uint8_t chunk[1 << 16];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0)
+        bytes.insert(bytes.end(), chunk, chunk + n);
+    fclose(f);
+
+    SpanFrameReader reader;
+    if (!reader.Open(bytes.data(), bytes.size())) return false;
+
+    size_t rowBytes = (size_t)reader.Width() * FrameBytesPerPixel(reader.Format());
+    storage.resize(rowBytes * (size_t)reader.Height());
+    if (!reader.DecodeFrame(storage.data(), rowBytes, reader.Format())) return false;
+
+    frame.data     = storage.data();
+    frame.width    = reader.Width();
+    frame.height   = reader.Height();
+    frame.rowPitch = rowBytes;
+    frame.format   = reader.Format();
+    return true;
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+// ---------------------------------------------------------------------------
+// SpanFrame
+//
+// Run-length frame format (.pqs) for storing and shipping pattern frames.
+// Scanlines are stored as constant-texel spans and identical consecutive
+// scanlines as one row group, so a 4K bar frame takes a few kilobytes
+// instead of 33 MB. All integers are little-endian, varints are LEB128:
+//
+//   header   "PQSP"  u16 version  u16 format  u32 width  u32 height
+//   groups   varint rows, varint spans, then per span:
+//              varint (length << 1 | reuse), texel (4 / 8 bytes) unless reuse
+//            `reuse` repeats the texel of the span two back in the same
+//            group, which covers label text alternating with its background.
+//   end      varint 0
+//   index    per group: u32 y0, u64 byte offset of its record
+//   trailer  u64 index offset  u32 group count  "PQSE"
+//
+// The encoder writes groups as soon as they are complete, so a frame can be
+// streamed to a file or socket while it is produced; the index and trailer
+// follow the end marker. Readers use the index for random access by scanline.
+// ---------------------------------------------------------------------------
+
+#include "PatternCore.h"
+
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+class RenderPlan;
+
+class SpanFrameEncoder
+{
+public:
+    // Receives encoded bytes in order; returning false aborts the encode
+    typedef std::function<bool(const uint8_t* data, size_t size)> Sink;
+
+    SpanFrameEncoder(FrameFormat format, int width, int height, Sink sink);
+
+    // Appends `count` scanlines; rows must arrive top to bottom
+    bool AddRows(const void* data, size_t rowPitch, int count);
+
+    // Encodes a whole compiled plan from its spans, without pixels. Only valid
+    // on a fresh encoder whose size and format match the plan.
+    bool AddPlan(const RenderPlan& plan);
+
+    // Writes the last group, the index and the trailer. False if the sink
+    // failed or fewer than `height` rows were added.
+    bool Finish();
+
+    uint64_t BytesWritten() const { return m_written + m_buffer.size(); }
+
+private:
+    struct IndexEntry
+    {
+        int      y0;
+        uint64_t offset;
+    };
+
+    void BeginGroup(int y0, int rows, size_t spanCount);
+    void PutTexel(uint64_t texel);
+    void PutVarint(uint64_t v);
+    void PutBytes(const void* data, size_t size);
+    void FlushPending();
+    bool Drain(bool force);
+
+    FrameFormat             m_format;
+    int                     m_width;
+    int                     m_height;
+    size_t                  m_texelBytes;
+    Sink                    m_sink;
+
+    std::vector<uint8_t>    m_buffer;           // encoded bytes not yet sunk
+    uint64_t                m_written = 0;      // bytes handed to the sink
+    bool                    m_failed  = false;
+
+    std::vector<uint8_t>    m_pendingRow;       // last distinct scanline
+    int                     m_pendingY0   = 0;
+    int                     m_pendingRows = 0;
+    int                     m_rowsAdded   = 0;
+
+    std::vector<IndexEntry> m_index;
+    std::vector<std::pair<int, uint64_t>> m_runs;   // (length, texel) of the pending row
+};
+
+class SpanFrameReader
+{
+public:
+    // Validates header, trailer and index. `data` must outlive the reader.
+    bool Open(const uint8_t* data, size_t size, std::string* error = nullptr);
+
+    int         Width() const       { return m_width; }
+    int         Height() const      { return m_height; }
+    FrameFormat Format() const      { return m_format; }
+    size_t      GroupCount() const  { return m_index.size(); }
+
+    // Decodes scanlines [y0, y1) into `dst` (which points at scanline y0),
+    // converting texels to `target` if it differs from the stored format.
+    // False if the range is invalid or a record is corrupt.
+    bool DecodeRows(int y0, int y1, void* dst, size_t rowPitch, FrameFormat target) const;
+
+    // `workers` <= 0 picks a thread count automatically
+    bool DecodeFrame(void* dst, size_t rowPitch, FrameFormat target, int workers = 0) const;
+
+private:
+    struct IndexEntry
+    {
+        int      y0;
+        uint64_t offset;
+    };
+
+    const uint8_t*          m_data = nullptr;
+    size_t                  m_size = 0;
+    int                     m_width  = 0;
+    int                     m_height = 0;
+    FrameFormat             m_format = FRAME_R10G10B10A2;
+    std::vector<IndexEntry> m_index;
+};
+
+// Whole-frame helpers: encode to memory, or save / load a .pqs file
+bool EncodeSpanFrame(const FrameView& frame, std::vector<uint8_t>& out);
+bool SaveSpanFrame(const char* path, const FrameView& frame);
+bool LoadSpanFrame(const char* path, std::vector<uint8_t>& storage, FrameView& frame);
+
+// Converts one texel between the two frame formats (PQ code <-> scRGB half)
+uint64_t ConvertTexel(uint64_t texel, FrameFormat from, FrameFormat to);
@@ -0,0 +1,180 @@
+#include "SpanLayout.h"
+
+#include <algorithm>
+#include <cmath>
+
+// ---------------------------------------------------------------------------
+// Geometry helpers
+// ---------------------------------------------------------------------------
+
+namespace
+{
+
+int ToPixel(float fraction, int extent)
+{
+    int v = (int)lround((double)fraction * (double)extent);
+    return (v < 0) ? 0 : (v > extent ? extent : v);
+}
+
+// Ramps step evenly in PQ signal, not in nits
+float RampNits(double from, double to, int i, int count)
+{
+    double t = ((double)i + 0.5) / (double)count;
+    return (float)PatternPQDecode(from + t * (to - from));
+}
+
+// Boundaries of `cells` near-equal cells over [a, b]
+std::vector<int> CellEdges(int a, int b, int cells)
+{
+    std::vector<int> edges((size_t)cells + 1);
+    for (int i = 0; i <= cells; i++)
+        edges[i] = a + (int)lround((double)i * (double)(b - a) / (double)cells);
+    return edges;
+}
+
+} // namespace
+
+void AppendLayoutSpan(std::vector<LayoutSpan>& row, int x0, int x1, uint64_t texel, float nits)
+{
+    if (x1 <= x0) return;
+    if (!row.empty() && row.back().texel == texel && row.back().x1 == x0)
+        row.back().x1 = x1;
+    else
+        row.push_back(LayoutSpan{ x0, x1, texel, nits });
+}
+
+// ---------------------------------------------------------------------------
+// ShapeRasterizer
+// ---------------------------------------------------------------------------
+
+ShapeRasterizer::ShapeRasterizer(const PatternDesc& desc, int width, int height)
+{
+    const FrameFormat format = (FrameFormat)desc.params.outputMode;
+    m_background = LayoutSpan{ 0, width, PatternPackTexel(format, desc.backgroundNits), desc.backgroundNits };
+
+    for (const LayoutShape& s : desc.shapes)
+    {
+        Placed p;
+        p.kind = s.kind;
+
+        if (s.kind == SHAPE_WINDOW)
+        {
+            double side = sqrt((double)s.area / 100.0);
+            int w = (std::max)(1, (int)lround(width  * side));
+            int h = (std::max)(1, (int)lround(height * side));
+            p.x0 = (width  - w) / 2;
+            p.y0 = (height - h) / 2;
+            p.x1 = p.x0 + w;
+            p.y1 = p.y0 + h;
+        }
+        else
+        {
+            p.x0 = ToPixel(s.x0, width);
+            p.y0 = ToPixel(s.y0, height);
+            p.x1 = ToPixel(s.x1, width);
+            p.y1 = ToPixel(s.y1, height);
+        }
+        if (p.x1 <= p.x0 || p.y1 <= p.y0) continue;    // rounds to nothing
+
+        const int w = p.x1 - p.x0;
+        const int h = p.y1 - p.y0;
+
+        switch (s.kind)
+        {
+        case SHAPE_RECT:
+        case SHAPE_WINDOW:
+            AppendLayoutSpan(p.spans[0], p.x0, p.x1, PatternPackTexel(format, s.nits), s.nits);
+            break;
+
+        case SHAPE_RAMP_H:
+        {
+            // One span per distinct texel: a code-value ramp is ~1 span per code
+            double from = PatternPQEncode(s.nits), to = PatternPQEncode(s.nits2);
+            for (int i = 0; i < w; i++)
+            {
+                float nits = RampNits(from, to, i, w);
+                AppendLayoutSpan(p.spans[0], p.x0 + i, p.x0 + i + 1, PatternPackTexel(format, nits), nits);
+            }
+            break;
+        }
+
+        case SHAPE_RAMP_V:
+        {
+            double from = PatternPQEncode(s.nits), to = PatternPQEncode(s.nits2);
+            p.rowFill.resize((size_t)h);
+            for (int i = 0; i < h; i++)
+            {
+                float nits = RampNits(from, to, i, h);
+                p.rowFill[i] = LayoutSpan{ p.x0, p.x1, PatternPackTexel(format, nits), nits };
+            }
+            break;
+        }
+
+        case SHAPE_CHECKER:
+        {
+            const uint64_t texelA = PatternPackTexel(format, s.nits);
+            const uint64_t texelB = PatternPackTexel(format, s.nits2);
+            std::vector<int> cols = CellEdges(p.x0, p.x1, s.cols);
+            for (int parity = 0; parity < 2; parity++)
+            {
+                for (int c = 0; c < s.cols; c++)
+                {
+                    bool second = ((c + parity) & 1) != 0;
+                    AppendLayoutSpan(p.spans[parity], cols[c], cols[c + 1],
+                        second ? texelB : texelA, second ? s.nits2 : s.nits);
+                }
+            }
+            p.rowEdges = CellEdges(p.y0, p.y1, s.rows);
+            break;
+        }
+        }
+
+        m_shapes.push_back(std::move(p));
+    }
+}
+
+void ShapeRasterizer::Paint(std::vector<LayoutSpan>& row, const std::vector<LayoutSpan>& shape)
+{
+    // `shape` covers [x0, x1) without gaps: keep what lies outside it
+    const int x0 = shape.front().x0;
+    const int x1 = shape.back().x1;
+
+    m_scratch.clear();
+    size_t i = 0;
+    for (; i < row.size() && row[i].x0 < x0; i++)
+        AppendLayoutSpan(m_scratch, row[i].x0, (std::min)(row[i].x1, x0), row[i].texel, row[i].nits);
+    for (const LayoutSpan& s : shape)
+        AppendLayoutSpan(m_scratch, s.x0, s.x1, s.texel, s.nits);
+    for (i = (i > 0) ? i - 1 : 0; i < row.size(); i++)
+    {
+        if (row[i].x1 > x1)
+            AppendLayoutSpan(m_scratch, (std::max)(row[i].x0, x1), row[i].x1, row[i].texel, row[i].nits);
+    }
+    row.swap(m_scratch);
+}
+
+void ShapeRasterizer::Row(int y, std::vector<LayoutSpan>& out)
+{
+    out.clear();
+    out.push_back(m_background);
+
+    for (const Placed& p : m_shapes)
+    {
+        if (y < p.y0 || y >= p.y1) continue;
+
+        if (p.kind == SHAPE_RAMP_V)
+        {
+            m_single.assign(1, p.rowFill[y - p.y0]);
+            Paint(out, m_single);
+        }
+        else if (p.kind == SHAPE_CHECKER)
+        {
+            size_t cell = (size_t)(std::upper_bound(p.rowEdges.begin(), p.rowEdges.end(), y) - p.rowEdges.begin()) - 1;
+            Paint(out, p.spans[cell & 1]);
+        }
+        else
+        {
+            Paint(out, p.spans[0]);
+        }
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+// ---------------------------------------------------------------------------
+// SpanLayout
+//
+// Rasterizer for shape layouts (PATTERN_SHAPES in PatternDesc.h): rectangles,
+// centred windows, PQ-uniform ramps and checkerboards painted over a
+// background. Each shape is resolved to pixel edges once, up front, and every
+// scanline is produced as a short list of constant spans, so the work is
+// proportional to the number of edges rather than pixels. RenderPlan folds
+// the rows into its span table.
+// ---------------------------------------------------------------------------
+
+#include "PatternDesc.h"
+
+#include <vector>
+
+struct LayoutSpan
+{
+    int      x0;
+    int      x1;
+    uint64_t texel;     // PatternPackTexel() for the frame format
+    float    nits;      // for average picture level
+};
+
+// Appends [x0, x1), extending the last span instead when it continues it
+// with the same texel. Empty ranges are ignored.
+void AppendLayoutSpan(std::vector<LayoutSpan>& row, int x0, int x1, uint64_t texel, float nits);
+
+class ShapeRasterizer
+{
+public:
+    // `desc` must be a shape layout; width/height are the resolved frame size
+    ShapeRasterizer(const PatternDesc& desc, int width, int height);
+
+    // Spans covering scanline y from 0 to width, left to right
+    void Row(int y, std::vector<LayoutSpan>& out);
+
+private:
+    struct Placed
+    {
+        ShapeKind               kind;
+        int                     x0, y0, x1, y1;     // pixels, [x0, x1) x [y0, y1)
+        std::vector<LayoutSpan> spans[2];           // row pattern; [1] = odd checker rows
+        std::vector<int>        rowEdges;           // checker row boundaries
+        std::vector<LayoutSpan> rowFill;            // vertical ramp, one per scanline
+    };
+
+    void Paint(std::vector<LayoutSpan>& row, const std::vector<LayoutSpan>& shape);
+
+    LayoutSpan              m_background;
+    std::vector<Placed>     m_shapes;
+    std::vector<LayoutSpan> m_scratch;
+    std::vector<LayoutSpan> m_single;
+};
@@ -0,0 +1,175 @@
+// ---------------------------------------------------------------------------
+// ExportPatterns
+//
+// Exports every entry of a golden manifest (see GoldenManifest.h) as an image:
+// HDR10 PQ entries as 16-bit PNG, scRGB entries as half-float EXR. Runs the
+// render -> encode -> write pipeline and reports where the time went.
+//
+// --spans writes run-length .pqs frames (SpanFrame.h) instead of images.
+// --dither renders HDR10 manifest entries with the blue-noise dither
+// (BlueNoise.h) so their bars average to the exact requested luminance.
+//
+// With --library the input is a pattern library (see PatternDesc.h) instead;
+// each pattern is compiled to a render plan once, at its own size or the
+// --size default, with its bar spacing schedule (BarSchedule.h) baked in.
+//
+//   ExportPatterns <manifest> <outdir> [--render N] [--encode N] [--write N]
+//                  [--queue N] [--deflate N] [--batched]
+//                  [--spans] [--library] [--size W H] [--dither]
+//
+// Build (Linux):
+//   g++ -O2 -std=c++17 -pthread -I.. -o ExportPatterns ExportPatterns.cpp
+//       ../PatternCore.cpp ../PatternRenderer.cpp ../GoldenManifest.cpp
+//       ../FramePool.cpp ../ImageEncode.cpp ../ExportPipeline.cpp
+//       ../PatternDesc.cpp ../RenderPlan.cpp ../SpanLayout.cpp ../SpanFrame.cpp
+//       ../BlueNoise.cpp ../BarSchedule.cpp
+// ---------------------------------------------------------------------------
+
+#include "ExportPipeline.h"
+#include "GoldenManifest.h"
+#include "RenderPlan.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <tuple>
+
+static void PrintStage(const char* name, const ExportStageStats& s, int workers, double wall)
+{
+    double perItem = s.items ? s.busySeconds * 1000.0 / (double)s.items : 0.0;
+    double util    = (wall > 0.0) ? s.busySeconds / (wall * workers) * 100.0 : 0.0;
+    printf("  %-7s %2d workers  %5llu items  %8.2f ms/item  %5.1f%% busy  %llu stalls\n",
+        name, workers, (unsigned long long)s.items, perItem, util, (unsigned long long)s.stalls);
+}
+
+// Carves the frames the pipeline can hold at once (one per render and encode
+// worker plus a full render queue) before the clock starts, per frame shape
+// and never more than that shape has jobs.
+static bool ReserveFrames(FramePool& pool, const std::vector<ExportJob>& jobs, const ExportConfig& config)
+{
+    const int inFlight = (config.renderWorkers > 0 ? config.renderWorkers : 1)
+                       + (config.queueDepth    > 0 ? config.queueDepth    : 4)
+                       + (config.encodeWorkers > 0 ? config.encodeWorkers : 1);
+
+    std::map<std::tuple<int, int, int>, int> shapes;
+    for (const ExportJob& job : jobs)
+        shapes[std::make_tuple(job.params.outputMode, job.params.width, job.params.height)]++;
+
+    for (const auto& s : shapes)
+    {
+        int count = (s.second < inFlight) ? s.second : inFlight;
+        if (!pool.Reserve((FrameFormat)std::get<0>(s.first), std::get<1>(s.first), std::get<2>(s.first), count))
+            return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        fprintf(stderr,
+            "usage: ExportPatterns <manifest> <outdir> [--render N] [--encode N]\n"
+            "                      [--write N] [--queue N] [--deflate N] [--batched]\n"
+            "                      [--spans] [--library] [--size W H] [--dither]\n");
+        return 2;
+    }
+
+    ExportConfig config = DefaultExportConfig();
+    bool library = false;
+    bool dither  = false;
+    int  width = 3840, height = 2160;
+    for (int i = 3; i < argc; i++)
+    {
+        bool hasValue = (i + 1 < argc);
+        if      (strcmp(argv[i], "--batched") == 0)            config.writeMode      = EXPORT_WRITE_BATCHED;
+        else if (strcmp(argv[i], "--spans") == 0)              config.encoding       = EXPORT_ENCODE_SPANS;
+        else if (strcmp(argv[i], "--library") == 0)            library               = true;
+        else if (strcmp(argv[i], "--dither") == 0)             dither                = true;
+        else if (i + 2 < argc && strcmp(argv[i], "--size") == 0)
+        {
+            width  = atoi(argv[++i]);
+            height = atoi(argv[++i]);
+        }
+        else if (hasValue && strcmp(argv[i], "--render") == 0)  config.renderWorkers  = atoi(argv[++i]);
+        else if (hasValue && strcmp(argv[i], "--encode") == 0)  config.encodeWorkers  = atoi(argv[++i]);
+        else if (hasValue && strcmp(argv[i], "--write") == 0)   config.writeWorkers   = atoi(argv[++i]);
+        else if (hasValue && strcmp(argv[i], "--queue") == 0)   config.queueDepth     = atoi(argv[++i]);
+        else if (hasValue && strcmp(argv[i], "--deflate") == 0) config.deflateWorkers = atoi(argv[++i]);
+        else
+        {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    std::vector<ExportJob>   jobs;
+    std::vector<RenderPlan>  plans;
+    std::vector<GoldenEntry> entries;
+    std::string error;
+
+    if (library)
+    {
+        auto t0 = std::chrono::steady_clock::now();
+        PatternLibrary lib;
+        if (!LoadPatternLibrary(argv[1], lib, &error))
+        {
+            fprintf(stderr, "%s\n", error.c_str());
+            return 2;
+        }
+
+        plans.resize(lib.patterns.size());
+        for (size_t i = 0; i < lib.patterns.size(); i++)
+        {
+            if (!RenderPlan::Compile(lib.patterns[i], width, height, plans[i], &error))
+            {
+                fprintf(stderr, "%s\n", error.c_str());
+                return 2;
+            }
+        }
+
+        size_t spans = 0;
+        for (const RenderPlan& plan : plans)
+        {
+            spans += plan.Spans().size();
+            jobs.push_back(ExportJob{ plan.Params(), std::string(argv[2]) + "/" + plan.Name(), &plan });
+        }
+        printf("%zu patterns compiled in %.1f ms (%zu spans)\n", plans.size(),
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count(), spans);
+    }
+    else
+    {
+        if (!LoadGoldenManifest(argv[1], entries, &error))
+        {
+            fprintf(stderr, "%s\n", error.c_str());
+            return 2;
+        }
+        for (GoldenEntry& e : entries)
+        {
+            e.params.dither = dither ? 1 : 0;
+            jobs.push_back(ExportJob{ e.params, std::string(argv[2]) + "/" + e.name });
+        }
+    }
+
+    FramePool   pool;
+    ExportStats stats;
+    if (!ReserveFrames(pool, jobs, config))
+        fprintf(stderr, "frame pool reservation failed; frames will be carved on demand\n");
+    bool ok = RunExportPipeline(jobs, config, pool, stats);
+
+    FramePoolStats ps = pool.Stats();
+    printf("%zu frames in %.3f s (%.1f frames/s), %.1f MB written, %llu failed\n",
+        jobs.size(), stats.wallSeconds,
+        stats.wallSeconds > 0.0 ? (double)jobs.size() / stats.wallSeconds : 0.0,
+        (double)stats.bytesWritten / (1024.0 * 1024.0), (unsigned long long)stats.failures);
+    PrintStage("render", stats.render, config.renderWorkers, stats.wallSeconds);
+    PrintStage("encode", stats.encode, config.encodeWorkers, stats.wallSeconds);
+    PrintStage("write",  stats.write,  config.writeWorkers,  stats.wallSeconds);
+    printf("  pool: %llu OS allocations, %llu carves, %llu reuses\n",
+        (unsigned long long)ps.osAllocations, (unsigned long long)ps.carves,
+        (unsigned long long)ps.reuses);
+
+    return ok ? 0 : 1;
+}
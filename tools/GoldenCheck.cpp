@@ -0,0 +1,353 @@
+// ---------------------------------------------------------------------------
+// GoldenCheck
+//
+// Renders every entry of a golden manifest with the CPU reference renderer and
+// checks the frame hashes. Entries whose hash moved are diffed against their
+// stored golden frame (if any) with a per-channel PQ-code tolerance, and a
+// heatmap of the moved pixels can be written for inspection. Golden frames
+// are stored run-length encoded (.pqs, see SpanFrame.h).
+//
+// Only the CPU reference (PatternRenderer) is checked. The shader in Main.cpp
+// is not rendered here, so a regression in its SampleValue / ApplyPQ leaves
+// every hash unchanged; that side is covered by the app's F12 GPU vs CPU
+// diff, which has to be run on an HDR display.
+//
+// selftest round-trips every default entry through an in-memory .pqs frame
+// and checks that truncated or corrupt trailers are rejected.
+//
+//   GoldenCheck init   <manifest> [--frames DIR]
+//   GoldenCheck update <manifest> [--frames DIR]
+//   GoldenCheck verify <manifest> [--frames DIR] [--tolerance N] [--heatmaps DIR]
+//   GoldenCheck selftest
+//
+// Build (Linux):
+//   g++ -O2 -std=c++17 -pthread -I.. -o GoldenCheck GoldenCheck.cpp
+//       ../PatternCore.cpp ../PatternRenderer.cpp ../FrameCompare.cpp
+//       ../GoldenManifest.cpp ../SpanFrame.cpp ../BlueNoise.cpp
+// ---------------------------------------------------------------------------
+
+#include "PatternRenderer.h"
+#include "FrameCompare.h"
+#include "GoldenManifest.h"
+#include "Parallel.h"
+#include "SpanFrame.h"
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+enum EntryStatus
+{
+    STATUS_MATCH,
+    STATUS_WITHIN_TOLERANCE,
+    STATUS_FAIL,
+    STATUS_NO_HASH,
+    STATUS_IO_ERROR
+};
+
+struct EntryResult
+{
+    EntryStatus status;
+    uint64_t    hash;
+    uint64_t    overTolerance;
+    int         maxDelta;
+    int         firstX;
+    int         firstY;
+};
+
+struct Options
+{
+    std::string command;
+    std::string manifest;
+    std::string framesDir;
+    std::string heatmapDir;
+    int         tolerance = 0;
+};
+
+static std::string JoinPath(const std::string& dir, const std::string& name, const char* ext)
+{
+    return dir + "/" + name + ext;
+}
+
+static void Usage()
+{
+    fprintf(stderr,
+        "usage: GoldenCheck init|update|verify <manifest> [--frames DIR]\n"
+        "                   [--tolerance N] [--heatmaps DIR]\n"
+        "       GoldenCheck selftest\n");
+}
+
+static bool ParseArgs(int argc, char** argv, Options& opt)
+{
+    if (argc < 2) return false;
+    opt.command = argv[1];
+    if (opt.command == "selftest") return argc == 2;
+
+    if (argc < 3) return false;
+    opt.manifest = argv[2];
+
+    for (int i = 3; i < argc; i++)
+    {
+        if (i + 1 >= argc) return false;
+        if      (strcmp(argv[i], "--frames") == 0)    opt.framesDir  = argv[++i];
+        else if (strcmp(argv[i], "--heatmaps") == 0)  opt.heatmapDir = argv[++i];
+        else if (strcmp(argv[i], "--tolerance") == 0) opt.tolerance  = atoi(argv[++i]);
+        else return false;
+    }
+
+    return opt.command == "init" || opt.command == "update" || opt.command == "verify";
+}
+
+static const int HASH_BAND_ROWS = 16;
+
+// Renders and hashes a frame through a small band buffer that stays in cache
+static uint64_t StreamHash(const PatternParams& p, size_t rowPitch, std::vector<uint8_t>& band)
+{
+    band.resize(rowPitch * HASH_BAND_ROWS);
+    uint64_t h = FrameHashSeed(p.width, p.height, (FrameFormat)p.outputMode);
+
+    for (int y0 = 0; y0 < p.height; y0 += HASH_BAND_ROWS)
+    {
+        int y1 = (y0 + HASH_BAND_ROWS < p.height) ? y0 + HASH_BAND_ROWS : p.height;
+        RenderPatternRows(p, band.data(), rowPitch, y0, y1);
+        for (int y = y0; y < y1; y++)
+            h = FrameHashFold(h, FrameHashRow(band.data() + (size_t)(y - y0) * rowPitch, rowPitch));
+    }
+    return h;
+}
+
+// Hashes one entry, then verifies or records it. Full frames are only
+// materialized when they have to be stored or diffed.
+static EntryResult ProcessEntry(const GoldenEntry& e, const Options& opt, bool record,
+    std::vector<uint8_t>& frame, std::vector<uint8_t>& golden)
+{
+    EntryResult r = {};
+    r.firstX = r.firstY = -1;
+
+    const PatternParams& p = e.params;
+    size_t rowPitch = (size_t)p.width * FrameBytesPerPixel((FrameFormat)p.outputMode);
+    r.hash = StreamHash(p, rowPitch, frame);
+
+    if (!record)
+    {
+        if (!e.hasHash)       { r.status = STATUS_NO_HASH; return r; }
+        if (r.hash == e.hash) { r.status = STATUS_MATCH;   return r; }
+        r.status = STATUS_FAIL;
+    }
+    else
+    {
+        r.status = STATUS_MATCH;
+    }
+
+    if (opt.framesDir.empty()) return r;
+
+    frame.resize(PatternFrameBytes(p));
+    RenderPatternFrame(p, frame.data(), rowPitch, 1);
+    FrameView view = { frame.data(), p.width, p.height, rowPitch, (FrameFormat)p.outputMode };
+
+    if (record)
+    {
+        if (!SaveSpanFrame(JoinPath(opt.framesDir, e.name, ".pqs").c_str(), view))
+            r.status = STATUS_IO_ERROR;
+        return r;
+    }
+
+    FrameView goldenView;
+    if (!LoadSpanFrame(JoinPath(opt.framesDir, e.name, ".pqs").c_str(), golden, goldenView))
+        return r;
+
+    FrameDiffOptions diffOpt = { opt.tolerance, !opt.heatmapDir.empty(), 1 };
+    FrameDiff diff;
+    if (!DiffFrames(goldenView, view, diffOpt, diff)) return r;
+
+    r.overTolerance = diff.overTolerance;
+    r.maxDelta      = diff.maxDelta;
+    r.firstX        = diff.firstX;
+    r.firstY        = diff.firstY;
+    if (diff.overTolerance == 0) r.status = STATUS_WITHIN_TOLERANCE;
+
+    if (!opt.heatmapDir.empty() && diff.differing)
+        WriteDiffHeatmap(diff, JoinPath(opt.heatmapDir, e.name, ".ppm").c_str());
+
+    return r;
+}
+
+// ---------------------------------------------------------------------------
+// Self test
+// ---------------------------------------------------------------------------
+
+static void PutLE(std::vector<uint8_t>& bytes, size_t at, uint64_t v, int count)
+{
+    for (int i = 0; i < count; i++)
+        bytes[at + i] = (uint8_t)(v >> (8 * i));
+}
+
+static bool Rejects(const std::vector<uint8_t>& bytes, size_t size)
+{
+    SpanFrameReader reader;
+    return !reader.Open(bytes.data(), size);
+}
+
+// Truncated copies and trailers whose index lies outside the file must fail
+// Open rather than be read. Trailer: u64 index offset, u32 group count, magic.
+static bool RejectsCorruptTrailers(const std::vector<uint8_t>& bytes, int height)
+{
+    const size_t trailer  = bytes.size() - 16;
+    const uint64_t groups = (uint64_t)(bytes[trailer + 8] | (bytes[trailer + 9] << 8)
+        | (bytes[trailer + 10] << 16) | ((uint32_t)bytes[trailer + 11] << 24));
+
+    for (size_t cut = 1; cut <= 16; cut++)
+        if (!Rejects(bytes, bytes.size() - cut)) return false;
+    if (!Rejects(bytes, bytes.size() / 2)) return false;
+
+    std::vector<uint8_t> bad = bytes;
+    PutLE(bad, trailer, bytes.size(), 8);                   // index past the end
+    if (!Rejects(bad, bad.size())) return false;
+
+    bad = bytes;
+    PutLE(bad, trailer, ~0ull, 8);                          // offset near 2^64
+    if (!Rejects(bad, bad.size())) return false;
+
+    // Offset chosen so offset + count * 12 wraps around to the trailer
+    bad = bytes;
+    PutLE(bad, trailer + 8, (uint64_t)height, 4);
+    PutLE(bad, trailer, (uint64_t)trailer - (uint64_t)height * 12u, 8);
+    if ((uint64_t)height * 12u > trailer && !Rejects(bad, bad.size())) return false;
+
+    bad = bytes;
+    PutLE(bad, trailer + 8, groups + 1, 4);                 // count / size mismatch
+    return Rejects(bad, bad.size());
+}
+
+static int SelfTest()
+{
+    std::vector<GoldenEntry> entries = DefaultGoldenEntries();
+    std::vector<int> failed(entries.size(), 0);
+
+    int workers = ParallelWorkerCount((int)entries.size(), 1);
+    ParallelForBands((int)entries.size(), workers, [&](int, int begin, int end)
+    {
+        std::vector<uint8_t> frame, decoded, bytes;
+        for (int i = begin; i < end; i++)
+        {
+            const PatternParams& p = entries[i].params;
+            size_t rowPitch = (size_t)p.width * FrameBytesPerPixel((FrameFormat)p.outputMode);
+            frame.resize(PatternFrameBytes(p));
+            RenderPatternFrame(p, frame.data(), rowPitch, 1);
+            FrameView view = { frame.data(), p.width, p.height, rowPitch, (FrameFormat)p.outputMode };
+
+            SpanFrameReader reader;
+            decoded.assign(frame.size(), 0);
+            bytes.clear();
+            bool ok = EncodeSpanFrame(view, bytes)
+                && reader.Open(bytes.data(), bytes.size())
+                && reader.DecodeFrame(decoded.data(), rowPitch, view.format, 1)
+                && decoded == frame;
+            if (!ok)                                           failed[i] |= 1;
+            else if (!RejectsCorruptTrailers(bytes, p.height)) failed[i] |= 2;
+        }
+    });
+
+    int failures = 0;
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        if (failed[i] & 1) printf("FAIL      %s: round trip\n", entries[i].name.c_str());
+        if (failed[i] & 2) printf("FAIL      %s: corrupt trailer accepted\n", entries[i].name.c_str());
+        if (failed[i]) failures++;
+    }
+    printf("%zu frames round-tripped, %d failed\n", entries.size(), failures);
+    return failures ? 1 : 0;
+}
+
+int main(int argc, char** argv)
+{
+    Options opt;
+    if (!ParseArgs(argc, argv, opt))
+    {
+        Usage();
+        return 2;
+    }
+    if (opt.command == "selftest") return SelfTest();
+
+    std::vector<GoldenEntry> entries;
+    if (opt.command == "init")
+    {
+        entries = DefaultGoldenEntries();
+    }
+    else
+    {
+        std::string error;
+        if (!LoadGoldenManifest(opt.manifest.c_str(), entries, &error))
+        {
+            fprintf(stderr, "%s\n", error.c_str());
+            return 2;
+        }
+    }
+
+    const bool record = (opt.command != "verify");
+    auto start = std::chrono::steady_clock::now();
+
+    // Frames are independent: spread entries over workers, one thread per
+    // frame, each worker reusing its own buffers.
+    std::vector<EntryResult> results(entries.size());
+    int workers = ParallelWorkerCount((int)entries.size(), 1);
+    ParallelForBands((int)entries.size(), workers, [&](int, int begin, int end)
+    {
+        std::vector<uint8_t> frame, golden;
+        for (int i = begin; i < end; i++)
+            results[i] = ProcessEntry(entries[i], opt, record, frame, golden);
+    });
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    int failures = 0;
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        const EntryResult& r = results[i];
+        switch (r.status)
+        {
+        case STATUS_MATCH:
+            break;
+        case STATUS_WITHIN_TOLERANCE:
+            printf("TOLERATED %s: max delta %d\n", entries[i].name.c_str(), r.maxDelta);
+            break;
+        case STATUS_NO_HASH:
+            printf("NOHASH    %s: %016" PRIx64 "\n", entries[i].name.c_str(), r.hash);
+            failures++;
+            break;
+        case STATUS_IO_ERROR:
+            printf("IOERROR   %s\n", entries[i].name.c_str());
+            failures++;
+            break;
+        case STATUS_FAIL:
+            if (r.firstY >= 0)
+                printf("FAIL      %s: %016" PRIx64 ", %" PRIu64 " px over tolerance, max delta %d, first at (%d, %d)\n",
+                    entries[i].name.c_str(), r.hash, r.overTolerance, r.maxDelta, r.firstX, r.firstY);
+            else
+                printf("FAIL      %s: %016" PRIx64 "\n", entries[i].name.c_str(), r.hash);
+            failures++;
+            break;
+        }
+    }
+
+    if (record)
+    {
+        for (size_t i = 0; i < entries.size(); i++)
+        {
+            entries[i].hash    = results[i].hash;
+            entries[i].hasHash = true;
+        }
+        if (!SaveGoldenManifest(opt.manifest.c_str(), entries))
+        {
+            fprintf(stderr, "cannot write %s\n", opt.manifest.c_str());
+            return 2;
+        }
+    }
+
+    printf("%zu frames in %.3f s, %d failed\n", entries.size(), seconds, failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,91 @@
+// ---------------------------------------------------------------------------
+// PrecisionScan
+//
+// Sweeps start / end luminance and bar counts, evaluating every bar through
+// the shader's float path and a high-precision reference (PrecisionCheck.h),
+// and reports where label text or PQ codes diverge. --maps writes per
+// (start, end) heatmaps of mismatching bars: <prefix>_labels.ppm and
+// <prefix>_codes.ppm, with end luminance along x and start along y.
+//
+//   PrecisionScan [--start MIN MAX STEPS] [--end MIN MAX STEPS]
+//                 [--bars MIN MAX] [--cases N] [--workers N] [--maps PREFIX]
+//
+// Build (Linux):
+//   g++ -O2 -std=c++17 -pthread -I.. -o PrecisionScan PrecisionScan.cpp
+//       ../PatternCore.cpp ../PrecisionCheck.cpp ../FrameCompare.cpp
+// ---------------------------------------------------------------------------
+
+#include "PrecisionCheck.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+int main(int argc, char** argv)
+{
+    // Default: the near-black range of the toolbar defaults, 2..64 bars
+    PrecisionGrid grid = { 0.002, 0.006, 250, 0.002, 0.006, 250, 2, 64 };
+    int         cases   = 24;
+    int         workers = 0;
+    std::string maps;
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasValue = (i + 1 < argc);
+        if (i + 3 < argc && strcmp(argv[i], "--start") == 0)
+        {
+            grid.startMin   = atof(argv[++i]);
+            grid.startMax   = atof(argv[++i]);
+            grid.startSteps = atoi(argv[++i]);
+        }
+        else if (i + 3 < argc && strcmp(argv[i], "--end") == 0)
+        {
+            grid.endMin   = atof(argv[++i]);
+            grid.endMax   = atof(argv[++i]);
+            grid.endSteps = atoi(argv[++i]);
+        }
+        else if (i + 2 < argc && strcmp(argv[i], "--bars") == 0)
+        {
+            grid.barsMin = atoi(argv[++i]);
+            grid.barsMax = atoi(argv[++i]);
+        }
+        else if (hasValue && strcmp(argv[i], "--cases") == 0)   cases   = atoi(argv[++i]);
+        else if (hasValue && strcmp(argv[i], "--workers") == 0) workers = atoi(argv[++i]);
+        else if (hasValue && strcmp(argv[i], "--maps") == 0)    maps    = argv[++i];
+        else
+        {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    PrecisionReport report;
+    if (!RunPrecisionScan(grid, report, cases, workers))
+    {
+        fprintf(stderr, "invalid grid\n");
+        return 2;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    printf("start %.9g..%.9g x%d, end %.9g..%.9g x%d, %d..%d bars: %.2f s (%.1f M bars/s)\n",
+        grid.startMin, grid.startMax, grid.startSteps, grid.endMin, grid.endMax, grid.endSteps,
+        grid.barsMin, grid.barsMax, seconds, seconds > 0.0 ? (double)report.bars / seconds / 1e6 : 0.0);
+    printf("%s", FormatPrecisionReport(report, cases).c_str());
+
+    if (!maps.empty())
+    {
+        std::string labels = maps + "_labels.ppm";
+        std::string codes  = maps + "_codes.ppm";
+        if (!WritePrecisionMap(report, PRECISION_LABEL, labels.c_str())
+            || !WritePrecisionMap(report, PRECISION_CODE, codes.c_str()))
+        {
+            fprintf(stderr, "cannot write %s / %s\n", labels.c_str(), codes.c_str());
+            return 1;
+        }
+    }
+
+    return (report.labelMismatches || report.codeMismatches) ? 1 : 0;
+}
@@ -0,0 +1,128 @@
+// ---------------------------------------------------------------------------
+// SequenceSim
+//
+// Runs a temporal test sequence (see FrameSequencer.h) against a simulated
+// vsync clock and reports pacing: the same scheduling code the app uses,
+// with a deterministic display so pacing logic and sequences can be checked
+// anywhere. Render cost, periodic stalls and vblank jitter are modelled.
+//
+//   SequenceSim [flicker|step|ramp] [--refresh HZ] [--target HZ]
+//               [--policy hold|all] [--render MS] [--stall N MS]
+//               [--jitter MS] [--seed N] [--library FILE --sequence NAME]
+//               [--csv FILE]
+//
+// Build (Linux):
+//   g++ -O2 -std=c++17 -I.. -o SequenceSim SequenceSim.cpp
+//       ../PatternCore.cpp ../PatternDesc.cpp ../FrameSequencer.cpp
+// ---------------------------------------------------------------------------
+
+#include "FrameSequencer.h"
+#include "PatternDesc.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+int main(int argc, char** argv)
+{
+    std::string test = "flicker", library, sequence, csv;
+    PacingConfig config = { 120.0, 60.0, PACING_HOLD_TIMELINE };
+    double renderMs = 2.0, stallMs = 0.0, jitterMs = 0.0;
+    int    stallEvery = 0;
+    uint32_t seed = 1;
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasValue = (i + 1 < argc);
+        if      (argv[i][0] != '-')                              test = argv[i];
+        else if (hasValue && strcmp(argv[i], "--refresh") == 0)  config.refreshHz = atof(argv[++i]);
+        else if (hasValue && strcmp(argv[i], "--target") == 0)   config.targetHz  = atof(argv[++i]);
+        else if (hasValue && strcmp(argv[i], "--render") == 0)   renderMs = atof(argv[++i]);
+        else if (hasValue && strcmp(argv[i], "--jitter") == 0)   jitterMs = atof(argv[++i]);
+        else if (hasValue && strcmp(argv[i], "--seed") == 0)     seed = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (hasValue && strcmp(argv[i], "--library") == 0)  library  = argv[++i];
+        else if (hasValue && strcmp(argv[i], "--sequence") == 0) sequence = argv[++i];
+        else if (hasValue && strcmp(argv[i], "--csv") == 0)      csv = argv[++i];
+        else if (hasValue && strcmp(argv[i], "--policy") == 0)
+        {
+            i++;
+            config.policy = (strcmp(argv[i], "all") == 0) ? PACING_SHOW_ALL : PACING_HOLD_TIMELINE;
+        }
+        else if (i + 2 < argc && strcmp(argv[i], "--stall") == 0)
+        {
+            stallEvery = atoi(argv[++i]);
+            stallMs    = atof(argv[++i]);
+        }
+        else
+        {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+    if (config.refreshHz <= 0.0 || config.targetHz <= 0.0)
+    {
+        fprintf(stderr, "refresh and target rates must be positive\n");
+        return 2;
+    }
+
+    // Toolbar defaults from Main.cpp
+    PatternParams base = { 0.005f, 0.00248f, 3840, 2160, 20, FRAME_R10G10B10A2, 5.0f, 0, 0.0f, nullptr };
+    NitsRange nearBlack = { base.startNits, base.endNits };
+    NitsRange black     = { 0.0f, 0.0f };
+
+    std::vector<SequenceFrame> frames;
+    std::string error;
+    if (!library.empty())
+    {
+        PatternLibrary lib;
+        if (!LoadPatternLibrary(library.c_str(), lib, &error)
+            || !BuildLibrarySequence(lib, lib.FindSequence(sequence), frames, &error))
+        {
+            fprintf(stderr, "%s\n", error.c_str());
+            return 2;
+        }
+    }
+    else if (test == "flicker") frames = BuildFlickerSequence(base, nearBlack, black, 1, 120);
+    else if (test == "step")    frames = BuildStepSequence(base, black, nearBlack, 60, 60);
+    else if (test == "ramp")    frames = BuildRampSweep(base, black, nearBlack, 240);
+    else
+    {
+        fprintf(stderr, "unknown test %s\n", test.c_str());
+        return 2;
+    }
+
+    SimulatedVsyncClock clock(config.refreshHz, jitterMs, seed);
+    FrameSequencer sequencer;
+    sequencer.Start(frames, config);
+
+    // Same loop shape as Render() in Main.cpp: pick the frame for the vblank
+    // the next present can reach, render it, present with sync interval 1.
+    uint64_t presents = 0;
+    for (;;)
+    {
+        int index = sequencer.FrameForVblank(clock.NextVblank());
+        if (index < 0) break;
+
+        double work = renderMs;
+        if (stallEvery > 0 && (presents + 1) % (uint64_t)stallEvery == 0) work += stallMs;
+        clock.Advance(work / 1000.0);
+
+        int64_t shown = clock.Present();
+        sequencer.Displayed(index, shown, clock.Now());
+        presents++;
+    }
+
+    printf("%s: %zu frames, %.2f Hz display, %.2f Hz target, %s, %llu presents\n",
+        library.empty() ? test.c_str() : sequence.c_str(), frames.size(), config.refreshHz, config.targetHz,
+        config.policy == PACING_HOLD_TIMELINE ? "hold timeline" : "show all",
+        (unsigned long long)presents);
+    printf("%s", FormatPacingStats(sequencer.Stats()).c_str());
+
+    if (!csv.empty() && !sequencer.WriteCsv(csv.c_str()))
+    {
+        fprintf(stderr, "cannot write %s\n", csv.c_str());
+        return 1;
+    }
+    return 0;
+}